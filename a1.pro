@@ -0,0 +1,16 @@
+# CPSC 453 Assignment 1 - falling blocks game.
+#
+#   engine  libtetris.a, the game engine with no Qt dependency
+#   gui     a1, the OpenGL game itself
+#   sim     tetris-sim, headless batch simulator
+#   bench   tetris-bench, engine benchmarks
+#   bot     tetris-bot, the autoplayer without a GUI
+#   replay  tetris-replay, plays recorded input logs back
+TEMPLATE = subdirs
+SUBDIRS = engine gui sim bench bot replay
+
+gui.depends = engine
+sim.depends = engine
+bench.depends = engine
+bot.depends = engine
+replay.depends = engine
@@ -0,0 +1,77 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * SnapshotArena - a bump allocator that game snapshots are carved out
+ * of.
+ */
+
+#include <atomic>
+
+#include "arena.h"
+
+namespace {
+
+const size_t ALIGN = 8;
+
+// Generations are drawn from one counter shared by every arena, so a
+// pointer into one arena is never mistaken for a pointer into another
+// that happens to live at the same address later.
+std::atomic<unsigned long> next_generation(1);
+
+} // namespace
+
+SnapshotArena::SnapshotArena(size_t block_size)
+  : block_size_(block_size)
+  , block_(0)
+  , offset_(0)
+  , used_(0)
+  , generation_(next_generation++)
+{
+  blocks_.push_back(new char[ block_size_ ]);
+}
+
+SnapshotArena::~SnapshotArena()
+{
+  clear();
+  for(size_t i = 0; i < blocks_.size(); ++i) {
+    delete [] blocks_[i];
+  }
+}
+
+void* SnapshotArena::allocate(size_t bytes)
+{
+  bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+  used_ += bytes;
+
+  // Anything bigger than a block gets an allocation of its own.
+  if(bytes > block_size_) {
+    large_.push_back(new char[ bytes ]);
+    return large_.back();
+  }
+
+  if(offset_ + bytes > block_size_) {
+    ++block_;
+    offset_ = 0;
+    if(block_ == blocks_.size()) {
+      blocks_.push_back(new char[ block_size_ ]);
+    }
+  }
+
+  void* p = blocks_[block_] + offset_;
+  offset_ += bytes;
+  return p;
+}
+
+void SnapshotArena::clear()
+{
+  for(size_t i = 0; i < large_.size(); ++i) {
+    delete [] large_[i];
+  }
+  large_.clear();
+
+  block_ = 0;
+  offset_ = 0;
+  used_ = 0;
+  generation_ = next_generation++;
+}
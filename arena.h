@@ -0,0 +1,55 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * SnapshotArena - a bump allocator that game snapshots are carved out
+ * of.  Nothing is freed on its own; the whole arena is cleared at once,
+ * which is how search code throws away a tree of positions.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+class SnapshotArena
+{
+public:
+  explicit SnapshotArena(size_t block_size = 1 << 16);
+  ~SnapshotArena();
+
+  // Room for bytes bytes, aligned for any of the types snapshots hold.
+  void* allocate(size_t bytes);
+
+  // Forget everything allocated so far, keeping the blocks for reuse.
+  // Every snapshot taken from the arena becomes invalid.
+  void clear();
+
+  // Changes on every clear(), so holders of pointers into the arena can
+  // tell that they have gone stale.
+  unsigned long getGeneration() const
+  {
+    return generation_;
+  }
+
+  // Bytes handed out since the last clear().
+  size_t bytesUsed() const
+  {
+    return used_;
+  }
+
+private:
+  SnapshotArena(const SnapshotArena&);
+  SnapshotArena& operator =(const SnapshotArena&);
+
+  std::vector<char*> blocks_;
+  std::vector<char*> large_;
+  size_t block_size_;
+  size_t block_;
+  size_t offset_;
+  size_t used_;
+  unsigned long generation_;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,411 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * BasicGame - the game for a well whose size is fixed at compile time.
+ * It plays by exactly the rules Game does, from the same pieces, but
+ * every row scan and collision check runs over a constant number of
+ * columns and words, so the compiler unrolls them, and the board lives
+ * inside the object rather than on the heap.
+ *
+ * The collision test and the skyline arithmetic are shared with Game
+ * through occupancy.h.  What is left here is the row storage and the
+ * line clear, which the fixed layout changes.
+ * Only play itself is here.  Journaling, snapshots and the board hash
+ * stay with Game, which handles wells of any size; use Game for those
+ * and for anything that takes a Game, such as the autoplayer.
+ */
+
+#ifndef BASICGAME_H
+#define BASICGAME_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "game.h"
+#include "occupancy.h"
+#include "piecesource.h"
+
+template <int W, int H>
+class BasicGame
+{
+  static_assert(W >= 4 && H >= 1, "the well must be wide enough to hold a piece");
+
+public:
+  // Rows of the board, including the four above the well where a new
+  // piece starts to fall, and words in each row.
+  static const int ROWS = H + 4;
+  static const int WORDS = (W + 63) / 64;
+
+  explicit BasicGame(const PieceSource& pieces = PieceSource())
+    : pieces_(pieces)
+  {
+    reset();
+  }
+
+  // As Game::reset().
+  void reset();
+  void reset(uint64_t seed)
+  {
+    pieces_.reseed(seed);
+    reset();
+  }
+
+  // As the Game methods of the same names.
+  int tick();
+  bool moveLeft();
+  bool moveRight();
+  bool drop();
+  bool rotateCW();
+  bool rotateCCW();
+
+  // As Game::play(): lock the falling piece at p, a placement Game
+  // would have found for the same board.
+  int play(const Placement& p);
+
+  bool doesPieceFit(const Piece& p, int x, int y) const;
+  int landingRow(const Piece& p, int x) const;
+
+  const Piece& getPiece() const
+  {
+    return piece_;
+  }
+  int getPieceX() const
+  {
+    return px_;
+  }
+  int getPieceY() const
+  {
+    return py_;
+  }
+  const PieceSource& getPieceSource() const
+  {
+    return pieces_;
+  }
+
+  static constexpr int getWidth()
+  {
+    return W;
+  }
+  static constexpr int getHeight()
+  {
+    return H;
+  }
+
+  // The cell at row r and column c, for r in [0,H+4): -1 if empty,
+  // otherwise the colour index of the piece that filled it.
+  int get(int r, int c) const
+  {
+    return cells_[r][c];
+  }
+
+  int getColumnHeight(int c) const
+  {
+    return heights_[c];
+  }
+  bool isStopped() const
+  {
+    return stopped_;
+  }
+  const RowWord* getRowWords(int r) const
+  {
+    return rows_[r];
+  }
+
+private:
+  static RowWord lastWordMask()
+  {
+    return W % 64 ? (RowWord(1) << (W % 64)) - 1 : ~RowWord(0);
+  }
+
+  void markRow(int r, int x, unsigned bits, bool on);
+  void removePiece(const Piece& p, int x, int y);
+  void placePiece(const Piece& p, int x, int y);
+  bool tryPiece(const Piece& p, int x, int y);
+  void generateNewPiece();
+
+  bool isFull(int r) const;
+  bool isEmpty(int r) const;
+  int removeFullRows(int lo, int hi);
+  void lowerHeight(int c, int h);
+
+  PieceSource pieces_;
+  Piece piece_;
+  int px_;
+  int py_;
+  bool stopped_;
+
+  // The occupancy plane, which all game logic runs on, and the colour
+  // of each cell, only kept for get().
+  RowWord rows_[ROWS][WORDS];
+  int8_t cells_[ROWS][W];
+
+  // Skyline of the locked cells, as Game keeps it.
+  int heights_[W];
+};
+
+template <int W, int H>
+void BasicGame<W, H>::reset()
+{
+  stopped_ = false;
+  std::fill(&rows_[0][0], &rows_[0][0] + ROWS*WORDS, 0);
+  std::fill(&cells_[0][0], &cells_[0][0] + ROWS*W, -1);
+  std::fill(heights_, heights_ + W, 0);
+  generateNewPiece();
+}
+
+// A well up to 64 wide has rows of one word, where no mask can
+// straddle words, so that test folds away.
+template <int W, int H>
+bool BasicGame<W, H>::doesPieceFit(const Piece& p, int x, int y) const
+{
+  return Occupancy::pieceFits(p, x, y, W, [this](int r) {
+    return rows_[r];
+  }, WORDS > 1);
+}
+
+template <int W, int H>
+void BasicGame<W, H>::markRow(int r, int x, unsigned bits, bool on)
+{
+  Occupancy::markRowSpan(rows_[r], Occupancy::rowSpan(x, bits, WORDS > 1), on);
+}
+
+template <int W, int H>
+void BasicGame<W, H>::removePiece(const Piece& p, int x, int y)
+{
+  for(int r = 0; r < 4; ++r) {
+    unsigned bits = p.getRowBits(r);
+    if(!bits) {
+      continue;
+    }
+    markRow(y-r, x, bits, false);
+    for(int c = 0; c < 4; ++c) {
+      if(bits & (1 << c)) {
+        cells_[y-r][x+c] = -1;
+      }
+    }
+  }
+}
+
+template <int W, int H>
+void BasicGame<W, H>::placePiece(const Piece& p, int x, int y)
+{
+  for(int r = 0; r < 4; ++r) {
+    unsigned bits = p.getRowBits(r);
+    if(!bits) {
+      continue;
+    }
+    markRow(y-r, x, bits, true);
+    for(int c = 0; c < 4; ++c) {
+      if(bits & (1 << c)) {
+        cells_[y-r][x+c] = int8_t(p.getColourIndex());
+      }
+    }
+  }
+}
+
+// Move the falling piece to p at column x and row y if it fits there,
+// as the moves and rotations do.
+template <int W, int H>
+bool BasicGame<W, H>::tryPiece(const Piece& p, int x, int y)
+{
+  removePiece(piece_, px_, py_);
+  if(doesPieceFit(p, x, y)) {
+    placePiece(p, x, y);
+    piece_ = p;
+    px_ = x;
+    py_ = y;
+    return true;
+  } else {
+    placePiece(piece_, px_, py_);
+    return false;
+  }
+}
+
+template <int W, int H>
+void BasicGame<W, H>::generateNewPiece()
+{
+  piece_ = Piece(pieces_.next());
+  px_ = (W-3) / 2;
+  py_ = H + 3 - piece_.getBottomMargin();
+  placePiece(piece_, px_, py_);
+}
+
+template <int W, int H>
+int BasicGame<W, H>::tick()
+{
+  if(stopped_) {
+    return -1;
+  }
+
+  removePiece(piece_, px_, py_);
+  int ny = py_ - 1;
+
+  if(doesPieceFit(piece_, px_, ny)) {
+    placePiece(piece_, px_, ny);
+    py_ = ny;
+    return 0;
+  }
+
+  placePiece(piece_, px_, py_);
+  for(int c = 0; c < 4; ++c) {
+    int top = piece_.getColumnTop(c);
+    if(top >= 0) {
+      heights_[px_+c] = std::max(heights_[px_+c], py_ - top + 1);
+    }
+  }
+  if(py_ >= H) {
+    stopped_ = true;
+    return -1;
+  }
+
+  // Only the rows under the piece that just locked can have filled.
+  int rm = removeFullRows(std::max(py_ - 3, 0), py_);
+  generateNewPiece();
+  return rm;
+}
+
+template <int W, int H>
+int BasicGame<W, H>::play(const Placement& p)
+{
+  if(stopped_) {
+    return -1;
+  }
+
+  removePiece(piece_, px_, py_);
+  piece_ = Piece(piece_.getColourIndex(), p.rotation);
+  px_ = p.x;
+  py_ = p.y;
+  placePiece(piece_, px_, py_);
+  return tick();
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::moveLeft()
+{
+  return tryPiece(piece_, px_ - 1, py_);
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::moveRight()
+{
+  return tryPiece(piece_, px_ + 1, py_);
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::rotateCW()
+{
+  return tryPiece(piece_.rotateCW(), px_, py_);
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::rotateCCW()
+{
+  return tryPiece(piece_.rotateCCW(), px_, py_);
+}
+
+template <int W, int H>
+int BasicGame<W, H>::landingRow(const Piece& p, int x) const
+{
+  return Occupancy::landingRow(p, x, heights_);
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::drop()
+{
+  removePiece(piece_, px_, py_);
+
+  // From above the stack the landing row comes straight off the
+  // column heights; under an overhang the piece feels its way down.
+  int ny = landingRow(piece_, px_);
+  if(ny > py_) {
+    ny = py_;
+    while(doesPieceFit(piece_, px_, ny - 1)) {
+      --ny;
+    }
+  }
+
+  placePiece(piece_, px_, ny);
+  bool moved = ny != py_;
+  py_ = ny;
+  return moved;
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::isFull(int r) const
+{
+  for(int w = 0; w + 1 < WORDS; ++w) {
+    if(~rows_[r][w]) {
+      return false;
+    }
+  }
+  return rows_[r][WORDS-1] == lastWordMask();
+}
+
+template <int W, int H>
+bool BasicGame<W, H>::isEmpty(int r) const
+{
+  for(int w = 0; w < WORDS; ++w) {
+    if(rows_[r][w]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Remove the full rows among rows [lo,hi], sliding the rows above
+// down over the gaps, and bring the column heights down to match.
+template <int W, int H>
+int BasicGame<W, H>::removeFullRows(int lo, int hi)
+{
+  int cleared[ROWS];
+  int num_cleared = 0;
+  for(int r = lo; r <= hi; ++r) {
+    if(isFull(r)) {
+      cleared[num_cleared++] = r;
+    }
+  }
+  if(num_cleared == 0) {
+    return 0;
+  }
+
+  // Nothing above the highest occupied row has to move.
+  int top = ROWS;
+  while(isEmpty(top-1)) {
+    --top;
+  }
+
+  int dst = cleared[0];
+  for(int i = 0; i < num_cleared; ++i) {
+    int src = cleared[i] + 1;
+    int end = i + 1 < num_cleared ? cleared[i+1] : top;
+    std::copy(&rows_[src][0], &rows_[end][0], &rows_[dst][0]);
+    std::copy(&cells_[src][0], &cells_[end][0], &cells_[dst][0]);
+    dst += end - src;
+  }
+  std::fill(&rows_[dst][0], &rows_[top][0], 0);
+  std::fill(&cells_[dst][0], &cells_[top][0], -1);
+
+  // Each column drops by the number of cleared rows under its top;
+  // if its top cell was itself cleared, walk down to the next one.
+  for(int c = 0; c < W; ++c) {
+    int h = heights_[c];
+    if(h <= cleared[0]) {
+      continue;
+    }
+    lowerHeight(c, Occupancy::heightAfterClear(h, cleared, num_cleared));
+  }
+
+  return num_cleared;
+}
+
+template <int W, int H>
+void BasicGame<W, H>::lowerHeight(int c, int h)
+{
+  while(h > 0 && cells_[h-1][c] == -1) {
+    --h;
+  }
+  heights_[c] = h;
+}
+
+#endif // BASICGAME_H
@@ -0,0 +1,210 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * GameBatch - many independent wells stepped in lock-step.
+ */
+
+#include <algorithm>
+
+#include "batch.h"
+#include "workpool.h"
+
+namespace {
+
+// Wells handed to a pool worker at a time.
+const int WELLS_PER_TASK = 64;
+
+} // namespace
+
+namespace {
+
+bool supportedSize(int width, int height)
+{
+  return width >= 4 && width <= GameBatch::MAX_WIDTH
+    && height >= 1 && height <= GameBatch::MAX_HEIGHT;
+}
+
+} // namespace
+
+GameBatch::GameBatch(int count, int width, int height, uint64_t seed,
+                     PieceSource::Mode mode)
+  : count_(supportedSize(width, height) ? std::max(count, 0) : 0)
+  , width_(count_ ? width : 0)
+  , height_(count_ ? height : 0)
+  , stride_(height_ + 4)
+  , full_row_(width_ >= 64 ? ~uint64_t(0) : (uint64_t(1) << width_) - 1)
+{
+  rows_ = new uint64_t[ size_t(count_) * stride_ ];
+  kind_ = new uint8_t[ count_ ];
+  rotation_ = new uint8_t[ count_ ];
+  x_ = new int16_t[ count_ ];
+  y_ = new int16_t[ count_ ];
+  top_ = new int16_t[ count_ ];
+
+  sources_ = new PieceSource[ count_ ];
+  for(int i = 0; i < count_; ++i) {
+    sources_[i] = PieceSource(seed + i, mode);
+  }
+
+  reset();
+}
+
+GameBatch::~GameBatch()
+{
+  delete [] rows_;
+  delete [] kind_;
+  delete [] rotation_;
+  delete [] x_;
+  delete [] y_;
+  delete [] top_;
+  delete [] sources_;
+}
+
+void GameBatch::reset()
+{
+  for(int i = 0; i < count_; ++i) {
+    resetWell(i);
+  }
+}
+
+void GameBatch::resetWell(int i)
+{
+  std::fill(rows_ + i*stride_, rows_ + (i+1)*stride_, 0);
+  top_[i] = 0;
+  spawn(i);
+}
+
+// As Game::generateNewPiece.
+void GameBatch::spawn(int i)
+{
+  Piece p(sources_[i].next());
+  kind_[i] = p.getColourIndex();
+  rotation_[i] = 0;
+  x_[i] = (width_ - 3) / 2;
+  y_[i] = height_ + 3 - p.getBottomMargin();
+}
+
+// As Game::doesPieceFit, against well i's locked cells.
+bool GameBatch::fits(int i, const Piece& p, int x, int y) const
+{
+  if(x + p.getLeftMargin() < 0 || x + 3 - p.getRightMargin() >= width_) {
+    return false;
+  }
+  if(y + p.getBottomMargin() < 3) {
+    return false;
+  }
+
+  const uint64_t* rows = rows_ + i*stride_;
+  for(int r = 0; r < 4; ++r) {
+    uint64_t bits = p.getRowBits(r);
+    if(!bits) {
+      continue;
+    }
+    bits = x < 0 ? bits >> -x : bits << x;
+    if(rows[y-r] & bits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void GameBatch::step(const uint8_t* actions, int8_t* clears, uint8_t* done,
+                     WorkPool* pool)
+{
+  auto stepWells = [&](int begin, int end) {
+    for(int i = begin; i < end; ++i) {
+      int rm = stepWell(i, actions[i]);
+      done[i] = rm < 0;
+      clears[i] = rm < 0 ? 0 : rm;
+      if(rm < 0) {
+        resetWell(i);
+      }
+    }
+  };
+
+  if(!pool) {
+    stepWells(0, count_);
+    return;
+  }
+
+  long tasks = (count_ + WELLS_PER_TASK - 1) / WELLS_PER_TASK;
+  pool->run(tasks, [&](long t, int) {
+    int begin = int(t) * WELLS_PER_TASK;
+    stepWells(begin, std::min(begin + WELLS_PER_TASK, count_));
+  });
+}
+
+// Apply the action to well i and tick it, returning what Game::tick
+// would.
+int GameBatch::stepWell(int i, int action)
+{
+  Piece p(kind_[i], rotation_[i]);
+  int x = x_[i];
+  int y = y_[i];
+
+  switch(action) {
+  case LEFT:
+    x -= fits(i, p, x - 1, y);
+    break;
+  case RIGHT:
+    x += fits(i, p, x + 1, y);
+    break;
+  case ROTATE_CW:
+    if(fits(i, p.rotateCW(), x, y)) {
+      p = p.rotateCW();
+    }
+    break;
+  case ROTATE_CCW:
+    if(fits(i, p.rotateCCW(), x, y)) {
+      p = p.rotateCCW();
+    }
+    break;
+  case DROP:
+    while(fits(i, p, x, y - 1)) {
+      --y;
+    }
+    break;
+  }
+
+  if(fits(i, p, x, y - 1)) {
+    rotation_[i] = p.getRotation();
+    x_[i] = x;
+    y_[i] = y - 1;
+    return 0;
+  }
+
+  // Lock the piece.
+  uint64_t* rows = rows_ + i*stride_;
+  for(int r = 0; r < 4; ++r) {
+    uint64_t bits = p.getRowBits(r);
+    if(bits) {
+      rows[y-r] |= x < 0 ? bits >> -x : bits << x;
+    }
+  }
+  top_[i] = std::max(int(top_[i]), y - p.getTopMargin() + 1);
+
+  if(y >= height_) {
+    return -1;
+  }
+
+  // Slide the surviving rows down over the full ones.
+  int top = top_[i];
+  int dst = std::max(y - 3, 0);
+  while(dst < top && rows[dst] != full_row_) {
+    ++dst;
+  }
+  int removed = 0;
+  for(int src = dst; src < top; ++src) {
+    if(rows[src] == full_row_) {
+      ++removed;
+    } else {
+      rows[dst++] = rows[src];
+    }
+  }
+  std::fill(rows + dst, rows + top, 0);
+  top_[i] = dst;
+
+  spawn(i);
+  return removed;
+}
@@ -0,0 +1,122 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * GameBatch - many independent wells stepped in lock-step, for batch
+ * training.  The wells follow exactly the rules Game does, but are
+ * stored field by field across the whole batch: one array of rows,
+ * one of piece kinds, one of piece columns and so on, each indexed by
+ * well.  A well's rows are a single word each, and the falling piece
+ * is kept apart from them rather than drawn into them, so a step
+ * touches a few cache lines per well.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+
+#include "game.h"
+#include "piecesource.h"
+
+class WorkPool;
+
+class GameBatch
+{
+public:
+  // What a well does before it ticks.
+  enum Action {NONE, LEFT, RIGHT, ROTATE_CW, ROTATE_CCW, DROP};
+
+  // A row is one 64-bit word, and piece rows are 16-bit.
+  static const int MAX_WIDTH = 64;
+  static const int MAX_HEIGHT = INT16_MAX - 4;
+
+  // count wells of the given size.  Well i takes its pieces from
+  // PieceSource(seed + i, mode), so it plays out exactly as a Game
+  // with that source would.  A size outside [4, MAX_WIDTH] by
+  // [1, MAX_HEIGHT] is rejected: the batch is left with no wells, so
+  // check size().
+  GameBatch(int count, int width, int height, uint64_t seed,
+            PieceSource::Mode mode = PieceSource::UNIFORM);
+
+  ~GameBatch();
+
+  // Empty every well and start a new piece falling in each.
+  void reset();
+
+  // For every well i, apply actions[i] and then tick, as a player's
+  // key press followed by Game::tick() would.  clears[i] gets the
+  // number of rows removed and done[i] whether the well filled up.
+  // A well that
+  // fills up is reset at once, ready for the next step.  With a pool,
+  // the wells are split between its workers.
+  void step(const uint8_t* actions, int8_t* clears, uint8_t* done,
+            WorkPool* pool = nullptr);
+
+  int size() const
+  {
+    return count_;
+  }
+  int getWidth() const
+  {
+    return width_;
+  }
+  int getHeight() const
+  {
+    return height_;
+  }
+
+  // The locked cells of row r of well i, bit c set when column c is
+  // occupied; r is in [0,height+4) as with Game::get().  The falling
+  // piece is not included.
+  uint64_t getRowBits(int i, int r) const
+  {
+    return rows_[ i*stride_ + r ];
+  }
+
+  // The falling piece of well i and the column and row of its
+  // top-left corner.
+  Piece getPiece(int i) const
+  {
+    return Piece(kind_[i], rotation_[i]);
+  }
+  int getPieceX(int i) const
+  {
+    return x_[i];
+  }
+  int getPieceY(int i) const
+  {
+    return y_[i];
+  }
+
+private:
+  GameBatch(const GameBatch&);
+  GameBatch& operator =(const GameBatch&);
+
+  void resetWell(int i);
+  void spawn(int i);
+  bool fits(int i, const Piece& p, int x, int y) const;
+  int stepWell(int i, int action);
+
+  int count_;
+  int width_;
+  int height_;
+  int stride_;
+  uint64_t full_row_;
+
+  // height+4 row words per well, well after well.
+  uint64_t* rows_;
+
+  uint8_t* kind_;
+  uint8_t* rotation_;
+  int16_t* x_;
+  int16_t* y_;
+
+  // Highest occupied row plus one, per well, so a collapse only walks
+  // the stack.
+  int16_t* top_;
+
+  PieceSource* sources_;
+};
+
+#endif // BATCH_H
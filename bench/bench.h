@@ -0,0 +1,74 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Helpers shared by the tetris-bench scenarios.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+
+#include "game.h"
+
+// Call fn() until at least min_seconds have passed and return the
+// rate in operations per second, counting ops_per_call for each call.
+template <typename Fn>
+double measureRate(Fn fn, long ops_per_call, double min_seconds = 0.5)
+{
+  typedef std::chrono::steady_clock clock;
+
+  long calls = 0;
+  clock::time_point start = clock::now();
+  double elapsed = 0;
+
+  do {
+    fn();
+    ++calls;
+    elapsed = std::chrono::duration<double>(clock::now() - start).count();
+  } while(elapsed < min_seconds);
+
+  return calls * ops_per_call / elapsed;
+}
+
+// Results are folded into this so the optimizer keeps the work.
+extern volatile long benchSink;
+
+// Game's private steps, for scenarios that time them on their own.
+// Callers must only fill rows below the falling piece.
+struct GameProbe {
+  static int collapse(Game& game)
+  {
+    return game.collapse();
+  }
+};
+
+// Fill the bottom fill_rows rows of the well with random garbage at
+// the given density, from a fixed seed so runs are comparable.  Every
+// row is left with at least one hole.
+void fillGarbage(Game& game, int fill_rows, double density, unsigned seed);
+
+// The microbenchmark suite.  runSuite writes JSON to json_path, or to
+// stdout if it is null.  compareSuite flags every benchmark that got
+// slower than the baseline by more than threshold percent, and
+// returns non-zero if there were any.
+int runSuite(const char *json_path);
+int compareSuite(const char *baseline_path, double threshold);
+
+// Before/after scenarios.  Each returns non-zero if a consistency
+// check failed.
+int runCollisionBench();
+int runCollapseBench();
+int runDropBench();
+int runSnapshotBench();
+int runTranspositionBench();
+int runBatchBench();
+int runEvalBench();
+int runFixedBench();
+int runHugeBench();
+int runCellsBench();
+int runRewindBench();
+int runRecordsBench();
+
+#endif // BENCH_H
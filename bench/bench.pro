@@ -0,0 +1,13 @@
+# tetris-bench: throughput benchmarks for the game engine.
+TEMPLATE = app
+TARGET = tetris-bench
+CONFIG += console release
+CONFIG -= qt app_bundle
+
+include(../engine/engine.pri)
+
+HEADERS += bench.h cellwell.h
+SOURCES += main.cpp bench_batch.cpp bench_cells.cpp bench_collision.cpp \
+           bench_collapse.cpp bench_drop.cpp bench_eval.cpp bench_fixed.cpp \
+           bench_huge.cpp bench_records.cpp bench_rewind.cpp bench_snapshot.cpp \
+           bench_transtable.cpp suite.cpp
@@ -0,0 +1,123 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Batch stepping throughput: a loop over N Game objects, each taking
+ * an action and a tick, against one GameBatch::step over N wells, on
+ * the calling thread and then spread over a pool.
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "batch.h"
+#include "game.h"
+#include "workpool.h"
+#include "bench.h"
+
+namespace {
+
+const int STEPS = 64;
+
+// The same random actions for both sides, STEPS rounds of count.
+std::vector<uint8_t> makeActions(int count)
+{
+  std::mt19937 rng(11);
+  std::vector<uint8_t> actions(size_t(STEPS) * count);
+  for(size_t i = 0; i < actions.size(); ++i) {
+    actions[i] = uint8_t(rng() % 6);
+  }
+  return actions;
+}
+
+int benchBatch(int count, WorkPool& pool)
+{
+  const int width = 10;
+  const int height = 20;
+  std::vector<uint8_t> actions = makeActions(count);
+
+  std::vector<Game> games;
+  games.reserve(count);
+  for(int i = 0; i < count; ++i) {
+    games.push_back(Game(width, height, PieceSource(1 + i)));
+  }
+  GameBatch batch(count, width, height, 1);
+  GameBatch pooled(count, width, height, 1);
+
+  std::vector<int8_t> clears(count);
+  std::vector<uint8_t> done(count);
+
+  // Both sides play the same wells with the same actions, so they
+  // must clear the same rows.
+  long game_lines = 0;
+  long batch_lines = 0;
+  int round = 0;
+
+  double before = measureRate([&]() {
+    const uint8_t* a = &actions[ size_t(round % STEPS) * count ];
+    for(int i = 0; i < count; ++i) {
+      Game& g = games[i];
+      switch(a[i]) {
+      case GameBatch::LEFT: g.moveLeft(); break;
+      case GameBatch::RIGHT: g.moveRight(); break;
+      case GameBatch::ROTATE_CW: g.rotateCW(); break;
+      case GameBatch::ROTATE_CCW: g.rotateCCW(); break;
+      case GameBatch::DROP: g.drop(); break;
+      }
+      int rm = g.tick();
+      if(rm < 0) {
+        g.reset();
+      } else {
+        game_lines += rm;
+      }
+    }
+    ++round;
+  }, count);
+  int game_rounds = round;
+
+  round = 0;
+  double after = measureRate([&]() {
+    batch.step(&actions[ size_t(round % STEPS) * count ],
+               &clears[0], &done[0]);
+    for(int i = 0; round < game_rounds && i < count; ++i) {
+      batch_lines += clears[i];
+    }
+    ++round;
+  }, count);
+  if(round < game_rounds) {
+    std::printf("%d wells: too few batch rounds to check\n", count);
+  } else if(game_lines != batch_lines) {
+    std::printf("%d wells: %ld lines from Game, %ld from GameBatch\n",
+                count, game_lines, batch_lines);
+    return 1;
+  }
+
+  round = 0;
+  double parallel = measureRate([&]() {
+    pooled.step(&actions[ size_t(round % STEPS) * count ],
+                &clears[0], &done[0], &pool);
+    ++round;
+  }, count);
+
+  std::printf("%7d %14.0f %14.0f %8.2fx %14.0f\n",
+              count, before, after, after / before, parallel);
+  return 0;
+}
+
+} // namespace
+
+int runBatchBench()
+{
+  WorkPool pool;
+
+  std::printf("well steps/sec, 10x20, random actions\n");
+  std::printf("%7s %14s %14s %9s %14s\n",
+              "wells", "Game loop", "GameBatch", "speedup", "pooled");
+
+  int failed = 0;
+  failed |= benchBatch(64, pool);
+  failed |= benchBatch(1024, pool);
+  failed |= benchBatch(16384, pool);
+  return failed;
+}
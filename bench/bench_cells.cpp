@@ -0,0 +1,121 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Cell storage tradeoff: memory per game and tick throughput with an
+ * int per cell against a packed nibble per cell, over many 10x20
+ * wells played with random actions, plus the cost of reading every
+ * cell back through get() as a renderer would.
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "game.h"
+#include "bench.h"
+
+namespace {
+
+const int WIDTH = 10;
+const int HEIGHT = 20;
+const int GAMES = 4096;
+const int STEPS = 64;
+const int CHECKED_ROUNDS = 2 * STEPS;
+
+struct Side {
+  double bytes;
+  double ticks;
+  double reads;
+  int rounds;
+  long lines;
+};
+
+Side benchStorage(CellStorage storage, const std::vector<uint8_t>& actions)
+{
+  std::vector<Game> games;
+  games.reserve(GAMES);
+  for(int i = 0; i < GAMES; ++i) {
+    games.push_back(Game(WIDTH, HEIGHT, PieceSource(1 + i), storage));
+  }
+
+  Side side;
+  side.bytes = 0;
+  for(const Game& g : games) {
+    side.bytes += g.getMemoryUsage();
+  }
+  side.bytes /= GAMES;
+
+  // Over the first CHECKED_ROUNDS rounds both sides play the same
+  // games, so they must clear the same rows.
+  side.lines = 0;
+  int round = 0;
+  side.ticks = measureRate([&]() {
+    const uint8_t* a = &actions[ size_t(round % STEPS) * GAMES ];
+    for(int i = 0; i < GAMES; ++i) {
+      Game& g = games[i];
+      switch(a[i]) {
+      case 0: g.moveLeft(); break;
+      case 1: g.moveRight(); break;
+      case 2: g.rotateCW(); break;
+      case 3: g.drop(); break;
+      }
+      int rm = g.tick();
+      if(rm < 0) {
+        g.reset();
+      } else if(round < CHECKED_ROUNDS) {
+        side.lines += rm;
+      }
+    }
+    ++round;
+  }, GAMES);
+  side.rounds = round;
+
+  int next = 0;
+  side.reads = measureRate([&]() {
+    const Game& g = games[next++ % GAMES];
+    long sum = 0;
+    for(int r = 0; r < HEIGHT; ++r) {
+      for(int c = 0; c < WIDTH; ++c) {
+        sum += g.get(r, c);
+      }
+    }
+    benchSink += sum;
+  }, WIDTH * HEIGHT);
+  return side;
+}
+
+} // namespace
+
+int runCellsBench()
+{
+  std::mt19937 rng(17);
+  std::vector<uint8_t> actions(size_t(STEPS) * GAMES);
+  for(size_t i = 0; i < actions.size(); ++i) {
+    actions[i] = uint8_t(rng() % 5);
+  }
+
+  Side wide = benchStorage(CELLS_WIDE, actions);
+  Side packed = benchStorage(CELLS_PACKED, actions);
+
+  std::printf("%d games of %dx%d, random actions\n", GAMES, WIDTH, HEIGHT);
+  std::printf("%-8s %12s %14s %14s\n",
+              "cells", "bytes/game", "ticks/sec", "gets/sec");
+  std::printf("%-8s %12.0f %14.0f %14.0f\n", "wide",
+              wide.bytes, wide.ticks, wide.reads);
+  std::printf("%-8s %12.0f %14.0f %14.0f\n", "packed",
+              packed.bytes, packed.ticks, packed.reads);
+  std::printf("packed: %.2fx the memory, %.2fx the ticks/sec, "
+              "%.0f MB saved per million games\n",
+              packed.bytes / wide.bytes, packed.ticks / wide.ticks,
+              wide.bytes - packed.bytes);
+
+  if(wide.rounds < CHECKED_ROUNDS || packed.rounds < CHECKED_ROUNDS) {
+    std::printf("too few rounds to check\n");
+  } else if(wide.lines != packed.lines) {
+    std::printf("%ld lines with wide cells, %ld with packed\n",
+                wide.lines, packed.lines);
+    return 1;
+  }
+  return 0;
+}
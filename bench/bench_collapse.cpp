@@ -0,0 +1,107 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Line clear throughput: four-row clears at the bottom of a half-full
+ * stack, comparing Game::collapse against the original rescanning
+ * version on the standard well and on tall wells.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "game.h"
+#include "bench.h"
+#include "cellwell.h"
+
+namespace {
+
+int collapse(Game& game)
+{
+  return GameProbe::collapse(game);
+}
+int collapse(CellWell& well)
+{
+  return well.collapse();
+}
+
+// Run four-line clears against well, refilling the garbage stack
+// whenever it gets too short to clear from.  Returns clears/sec.
+// Only the clears themselves are timed.  The refills go through set(),
+// which on Game also keeps the hash, skyline and fill counts, and on a
+// 10x20 well the hundred-odd cells set for every clear would cost
+// several times the clear.  The clock reads land in both columns.
+template <typename Well>
+double measureClears(Well& well, int width, int height, long& removed)
+{
+  typedef std::chrono::steady_clock clock;
+
+  int stack = height / 2;
+  int left = 0;
+  long clears = 0;
+  double timed = 0;
+
+  Game source(width, height);
+  fillGarbage(source, stack, 0.6, 42);
+  std::vector<int> garbage;
+  for(int r = 0; r < stack; ++r) {
+    for(int c = 0; c < width; ++c) {
+      garbage.push_back(source.get(r, c));
+    }
+  }
+
+  measureRate([&]() {
+    if(left < 8) {
+      for(int r = 0; r < stack; ++r) {
+        for(int c = 0; c < width; ++c) {
+          well.set(r, c, garbage[ r*width + c ]);
+        }
+      }
+      left = stack;
+    }
+
+    for(int r = 0; r < 4; ++r) {
+      for(int c = 0; c < width; ++c) {
+        well.set(r, c, 0);
+      }
+    }
+    clock::time_point start = clock::now();
+    removed += collapse(well);
+    timed += std::chrono::duration<double>(clock::now() - start).count();
+    ++clears;
+    left -= 4;
+  }, 1);
+  return clears / timed;
+}
+
+int benchWell(int width, int height)
+{
+  Game game(width, height);
+  CellWell cells(game);
+
+  long before_rows = 0;
+  long after_rows = 0;
+  double before = measureClears(cells, width, height, before_rows);
+  double after = measureClears(game, width, height, after_rows);
+
+  std::printf("%5dx%-5d %14.0f %14.0f %8.2fx\n",
+              width, height, before, after, after / before);
+
+  // Every clear should take exactly the four rows that were filled.
+  return (before_rows % 4) != 0 || (after_rows % 4) != 0;
+}
+
+} // namespace
+
+int runCollapseBench()
+{
+  std::printf("four-line clears/sec\n");
+  std::printf("%-11s %14s %14s %9s\n", "well", "rescan", "single-pass", "speedup");
+
+  int failed = 0;
+  failed |= benchWell(10, 20);
+  failed |= benchWell(10, 1000);
+  failed |= benchWell(10, 10000);
+  return failed;
+}
@@ -0,0 +1,84 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Collision test throughput: the row-bitmask doesPieceFit against the
+ * original cell-by-cell version, on the standard well and wide wells.
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "game.h"
+#include "bench.h"
+#include "cellwell.h"
+
+namespace {
+
+struct Probe {
+  Piece piece;
+  int x;
+  int y;
+};
+
+int benchWell(int width, int height)
+{
+  Game game(width, height);
+  fillGarbage(game, height / 2, 0.6, 42);
+  CellWell cells(game);
+
+  // Random placements around the stack, in every orientation.
+  std::mt19937 rng(7);
+  std::vector<Probe> probes(4096);
+  for(size_t i = 0; i < probes.size(); ++i) {
+    probes[i].piece = Piece(rng() % 7, rng() % 4);
+    probes[i].x = int(rng() % (width + 2)) - 1;
+    probes[i].y = 3 + int(rng() % (height + 1));
+  }
+
+  long before_fits = 0;
+  long after_fits = 0;
+  for(size_t i = 0; i < probes.size(); ++i) {
+    before_fits += cells.doesPieceFit(probes[i].piece, probes[i].x, probes[i].y);
+    after_fits += game.doesPieceFit(probes[i].piece, probes[i].x, probes[i].y);
+  }
+  if(before_fits != after_fits) {
+    std::printf("%dx%d: mismatch, %ld fits before vs %ld after\n",
+                width, height, before_fits, after_fits);
+    return 1;
+  }
+
+  long sink = 0;
+  double before = measureRate([&]() {
+    for(size_t i = 0; i < probes.size(); ++i) {
+      sink += cells.doesPieceFit(probes[i].piece, probes[i].x, probes[i].y);
+    }
+  }, probes.size());
+  double after = measureRate([&]() {
+    for(size_t i = 0; i < probes.size(); ++i) {
+      sink += game.doesPieceFit(probes[i].piece, probes[i].x, probes[i].y);
+    }
+  }, probes.size());
+
+  benchSink = sink;
+
+  std::printf("%5dx%-5d %14.0f %14.0f %8.2fx\n",
+              width, height, before, after, after / before);
+  return 0;
+}
+
+} // namespace
+
+int runCollisionBench()
+{
+  std::printf("collision tests/sec\n");
+  std::printf("%-11s %14s %14s %9s\n", "well", "cells", "bitboard", "speedup");
+
+  int failed = 0;
+  failed |= benchWell(10, 20);
+  failed |= benchWell(64, 40);
+  failed |= benchWell(200, 100);
+  failed |= benchWell(1000, 100);
+  return failed;
+}
@@ -0,0 +1,89 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Landing prediction throughput: searching down a row at a time with
+ * doesPieceFit, as drop() used to, against Game::landingRow reading
+ * the column heights.  Tall wells are where the search hurts.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "game.h"
+#include "bench.h"
+
+namespace {
+
+struct Probe {
+  Piece piece;
+  int x;
+};
+
+// Start just below the four spawn rows, where the new piece sits.
+int searchLanding(const Game& game, const Piece& p, int x)
+{
+  int y = game.getHeight() - 1 + p.getTopMargin();
+  while(game.doesPieceFit(p, x, y - 1)) {
+    --y;
+  }
+  return y;
+}
+
+int benchWell(int width, int height)
+{
+  Game game(width, height);
+  fillGarbage(game, std::min(height / 2, 16), 0.6, 42);
+
+  std::mt19937 rng(7);
+  std::vector<Probe> probes(1024);
+  for(size_t i = 0; i < probes.size(); ++i) {
+    Piece p(rng() % 7, rng() % 4);
+    int lo = -p.getLeftMargin();
+    int hi = width - 4 + p.getRightMargin();
+    probes[i].piece = p;
+    probes[i].x = lo + int(rng() % (hi - lo + 1));
+  }
+
+  for(size_t i = 0; i < probes.size(); ++i) {
+    if(searchLanding(game, probes[i].piece, probes[i].x) !=
+       game.landingRow(probes[i].piece, probes[i].x)) {
+      std::printf("%dx%d: landing rows disagree\n", width, height);
+      return 1;
+    }
+  }
+
+  long sink = 0;
+  double before = measureRate([&]() {
+    for(size_t i = 0; i < probes.size(); ++i) {
+      sink += searchLanding(game, probes[i].piece, probes[i].x);
+    }
+  }, probes.size());
+  double after = measureRate([&]() {
+    for(size_t i = 0; i < probes.size(); ++i) {
+      sink += game.landingRow(probes[i].piece, probes[i].x);
+    }
+  }, probes.size());
+  benchSink = sink;
+
+  std::printf("%5dx%-5d %14.0f %14.0f %8.2fx\n",
+              width, height, before, after, after / before);
+  return 0;
+}
+
+} // namespace
+
+int runDropBench()
+{
+  std::printf("landing predictions/sec\n");
+  std::printf("%-11s %14s %14s %9s\n", "well", "row search", "heights", "speedup");
+
+  int failed = 0;
+  failed |= benchWell(10, 20);
+  failed |= benchWell(10, 1000);
+  failed |= benchWell(10, 10000);
+  failed |= benchWell(1000, 1000);
+  return failed;
+}
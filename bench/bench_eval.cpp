@@ -0,0 +1,109 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Board evaluation throughput: the feature kernel on each path the
+ * CPU supports, one board per call and a batch of boards per call, on
+ * the standard well, the widest well it takes and a tall well.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "boardeval.h"
+#include "bench.h"
+
+namespace {
+
+const EvalPath PATHS[] = { EVAL_SCALAR, EVAL_SSE2, EVAL_AVX2 };
+
+// Random stacks: each column a random height, each cell under it
+// filled most of the time, so there are holes, wells and transitions
+// to count.
+std::vector<uint64_t> makeBoards(int boards, int width, int rows)
+{
+  std::mt19937 rng(23);
+  std::vector<uint64_t> words(size_t(boards) * rows);
+  for(int b = 0; b < boards; ++b) {
+    uint64_t* board = &words[ size_t(b) * rows ];
+    for(int c = 0; c < width; ++c) {
+      int h = int(rng() % rows);
+      for(int r = 0; r < h; ++r) {
+        if(rng() % 5) {
+          board[r] |= uint64_t(1) << c;
+        }
+      }
+    }
+  }
+  return words;
+}
+
+int benchBoards(int boards, int width, int rows)
+{
+  std::vector<uint64_t> words = makeBoards(boards, width, rows);
+  std::vector<BoardEval> want(boards);
+  std::vector<BoardEval> got(boards);
+  EvalPath best = getEvalPath();
+  int failed = 0;
+
+  setEvalPath(EVAL_SCALAR);
+  evaluateBoards(&words[0], rows, boards, rows, width, &want[0]);
+
+  for(EvalPath path : PATHS) {
+    if(!setEvalPath(path)) {
+      continue;
+    }
+
+    // Every path must agree with the scalar one, both ways of
+    // calling it.
+    evaluateBoards(&words[0], rows, boards, rows, width, &got[0]);
+    for(int b = 0; b < boards; ++b) {
+      BoardEval one;
+      evaluateBoard(&words[ size_t(b) * rows ], rows, width, one);
+      if(std::memcmp(&got[b], &want[b], sizeof(BoardEval)) != 0 ||
+         std::memcmp(&one, &want[b], sizeof(BoardEval)) != 0) {
+        std::printf("%dx%d: %s disagrees with scalar on board %d\n",
+                    width, rows, getEvalPathName(path), b);
+        failed = 1;
+        break;
+      }
+    }
+
+    long sink = 0;
+    double single = measureRate([&]() {
+      for(int b = 0; b < boards; ++b) {
+        BoardEval e;
+        evaluateBoard(&words[ size_t(b) * rows ], rows, width, e);
+        sink += e.holes;
+      }
+    }, boards);
+    double batch = measureRate([&]() {
+      evaluateBoards(&words[0], rows, boards, rows, width, &got[0]);
+      sink += got[0].holes;
+    }, boards);
+    benchSink = sink;
+
+    std::printf("%5dx%-5d %-8s %14.0f %14.0f\n",
+                width, rows, getEvalPathName(path), single, batch);
+  }
+
+  setEvalPath(best);
+  return failed;
+}
+
+} // namespace
+
+int runEvalBench()
+{
+  std::printf("boards evaluated/sec, best path here: %s\n",
+              getEvalPathName(getEvalPath()));
+  std::printf("%-11s %-8s %14s %14s\n", "well", "path", "one by one", "batched");
+
+  int failed = 0;
+  failed |= benchBoards(4096, 10, 24);
+  failed |= benchBoards(1024, 64, 68);
+  failed |= benchBoards(64, 10, 1024);
+  return failed;
+}
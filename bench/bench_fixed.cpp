@@ -0,0 +1,149 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Fixed-size well throughput: BasicGame<10,20> against Game(10, 20),
+ * playing the same random moves and answering the same collision
+ * tests.
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "basicgame.h"
+#include "game.h"
+#include "bench.h"
+
+namespace {
+
+const int WIDTH = 10;
+const int HEIGHT = 20;
+
+typedef BasicGame<WIDTH, HEIGHT> FixedGame;
+
+// A key press and a tick, as the window does.  Returns what the tick
+// returned, after starting again on a game that ended.
+template <typename G>
+int step(G& game, int action)
+{
+  switch(action) {
+  case 1: game.moveLeft(); break;
+  case 2: game.moveRight(); break;
+  case 3: game.rotateCW(); break;
+  case 4: game.rotateCCW(); break;
+  case 5: game.drop(); break;
+  }
+  int rm = game.tick();
+  if(rm < 0) {
+    game.reset();
+  }
+  return rm;
+}
+
+template <typename G>
+long playOut(G& game, const std::vector<uint8_t>& actions)
+{
+  long lines = 0;
+  for(size_t i = 0; i < actions.size(); ++i) {
+    int rm = step(game, actions[i]);
+    lines += rm > 0 ? rm : 0;
+  }
+  return lines;
+}
+
+// Steps of play, leaving both games in the same state.
+int benchPlay(Game& game, FixedGame& fixed)
+{
+  std::mt19937 rng(5);
+  std::vector<uint8_t> actions(1 << 16);
+  for(size_t i = 0; i < actions.size(); ++i) {
+    actions[i] = uint8_t(rng() % 6);
+  }
+
+  // The same moves from the same pieces must clear the same rows.
+  long game_lines = playOut(game, actions);
+  long fixed_lines = playOut(fixed, actions);
+  if(game_lines != fixed_lines) {
+    std::printf("play: %ld lines from Game, %ld from BasicGame\n",
+                game_lines, fixed_lines);
+    return 1;
+  }
+
+  long sink = 0;
+  double before = measureRate([&]() {
+    sink += playOut(game, actions);
+  }, actions.size());
+  double after = measureRate([&]() {
+    sink += playOut(fixed, actions);
+  }, actions.size());
+  benchSink = sink;
+
+  // The timing ran each for its own number of rounds.
+  game.reset(3);
+  fixed.reset(3);
+  playOut(game, actions);
+  playOut(fixed, actions);
+
+  std::printf("%-12s %14.0f %14.0f %8.2fx\n",
+              "steps", before, after, after / before);
+  return 0;
+}
+
+// Collision tests around the stacks of two wells in the same state.
+int benchCollision(const Game& game, const FixedGame& fixed)
+{
+  std::mt19937 rng(7);
+  std::vector<Piece> pieces(4096);
+  std::vector<int> xs(pieces.size());
+  std::vector<int> ys(pieces.size());
+  for(size_t i = 0; i < pieces.size(); ++i) {
+    pieces[i] = Piece(rng() % 7, rng() % 4);
+    xs[i] = int(rng() % (WIDTH + 2)) - 1;
+    ys[i] = 3 + int(rng() % (HEIGHT + 1));
+  }
+
+  long game_fits = 0;
+  long fixed_fits = 0;
+  for(size_t i = 0; i < pieces.size(); ++i) {
+    game_fits += game.doesPieceFit(pieces[i], xs[i], ys[i]);
+    fixed_fits += fixed.doesPieceFit(pieces[i], xs[i], ys[i]);
+  }
+  if(game_fits != fixed_fits) {
+    std::printf("collisions: %ld fit in Game, %ld in BasicGame\n",
+                game_fits, fixed_fits);
+    return 1;
+  }
+
+  long sink = 0;
+  double before = measureRate([&]() {
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      sink += game.doesPieceFit(pieces[i], xs[i], ys[i]);
+    }
+  }, pieces.size());
+  double after = measureRate([&]() {
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      sink += fixed.doesPieceFit(pieces[i], xs[i], ys[i]);
+    }
+  }, pieces.size());
+  benchSink = sink;
+
+  std::printf("%-12s %14.0f %14.0f %8.2fx\n",
+              "collisions", before, after, after / before);
+  return 0;
+}
+
+} // namespace
+
+int runFixedBench()
+{
+  std::printf("operations/sec, 10x20 well\n");
+  std::printf("%-12s %14s %14s %9s\n", "", "Game", "BasicGame", "speedup");
+
+  Game game(WIDTH, HEIGHT, PieceSource(3));
+  FixedGame fixed(PieceSource(3));
+  if(benchPlay(game, fixed)) {
+    return 1;
+  }
+  return benchCollision(game, fixed);
+}
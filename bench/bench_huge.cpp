@@ -0,0 +1,95 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Line clears in very large wells: the time for Game::collapse to
+ * take four full rows out from under a stack filling half the well,
+ * as the well grows taller and wider, on the calling thread and with
+ * the per-column work spread over a pool.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "game.h"
+#include "workpool.h"
+#include "bench.h"
+
+namespace {
+
+// Microseconds per four-row clear.  The bottom four rows are filled
+// outside the timed region, and the stack is never refilled, so runs
+// stop well before it is used up.
+double timeClears(Game& game, int clears, long& removed)
+{
+  typedef std::chrono::steady_clock clock;
+  double seconds = 0;
+
+  for(int i = 0; i < clears; ++i) {
+    for(int r = 0; r < 4; ++r) {
+      for(int c = 0; c < game.getWidth(); ++c) {
+        game.set(r, c, 0);
+      }
+    }
+    clock::time_point start = clock::now();
+    removed += GameProbe::collapse(game);
+    seconds += std::chrono::duration<double>(clock::now() - start).count();
+  }
+
+  return seconds * 1e6 / clears;
+}
+
+int benchWell(int width, int height, WorkPool& pool)
+{
+  int stack = height / 2;
+  int clears = std::max(1, std::min(64, stack / 8));
+
+  Game game(width, height);
+  fillGarbage(game, stack, 0.6, 42);
+  Game pooled(game);
+  pooled.setWorkPool(&pool);
+
+  long removed = 0;
+  long pooled_removed = 0;
+  double serial = timeClears(game, clears, removed);
+  double parallel = timeClears(pooled, clears, pooled_removed);
+
+  // Every clear should take exactly the four rows that were filled,
+  // and leave the heights agreeing with the cells.
+  bool heights_ok = true;
+  for(int c = 0; c < width && heights_ok; ++c) {
+    int h = game.getColumnHeight(c);
+    heights_ok = h == pooled.getColumnHeight(c)
+      && (h == 0 || game.get(h - 1, c) != -1);
+  }
+  if(removed != 4L * clears || pooled_removed != removed || !heights_ok ||
+     game.getHash() != pooled.getHash()) {
+    std::printf("%dx%d: clears went wrong\n", width, height);
+    return 1;
+  }
+
+  std::printf("%6dx%-6d %12.1f %12.1f\n", width, height, serial, parallel);
+  return 0;
+}
+
+} // namespace
+
+int runHugeBench()
+{
+  WorkPool pool;
+
+  std::printf("microseconds per four-line clear, stack half full, %d threads\n",
+              pool.size());
+  std::printf("%-13s %12s %12s\n", "well", "serial", "pooled");
+
+  int failed = 0;
+  failed |= benchWell(10, 20, pool);
+  failed |= benchWell(10, 20000, pool);
+  failed |= benchWell(1024, 1000, pool);
+  failed |= benchWell(1024, 20000, pool);
+  failed |= benchWell(8192, 1000, pool);
+  failed |= benchWell(8192, 20000, pool);
+  failed |= benchWell(32768, 4000, pool);
+  return failed;
+}
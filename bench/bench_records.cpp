@@ -0,0 +1,131 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Record files: write the state of a stream of 10x20 games after
+ * every tick to a record file, then map it and scan every record,
+ * once cell by cell through get() and once a byte at a time.  Reports
+ * records and megabytes per second each way and checks the scans
+ * against what was written.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "game.h"
+#include "recordfile.h"
+#include "bench.h"
+
+namespace {
+
+const int WIDTH = 10;
+const int HEIGHT = 20;
+const long RECORDS = 250000;
+const char* const PATH = "tetris-bench-records.tmp";
+
+double seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int runRecordsBench()
+{
+  // Games driven by random key presses, each written after every
+  // tick, with the number of ticks so far as the score.
+  RecordWriter writer;
+  if(!writer.open(PATH, WIDTH, HEIGHT)) {
+    std::printf("cannot create %s\n", PATH);
+    return 1;
+  }
+  Game game(WIDTH, HEIGHT, PieceSource(5));
+  std::mt19937 rng(5);
+  long cells_written = 0;
+  double write_time = 0;
+  for(long i = 0; i < RECORDS; ++i) {
+    switch(rng() % 5) {
+    case 0: game.moveLeft(); break;
+    case 1: game.moveRight(); break;
+    case 2: game.rotateCW(); break;
+    case 3: game.drop(); break;
+    }
+    if(game.tick() < 0) {
+      game.reset();
+    }
+    for(int r = 0; r < HEIGHT + 4; ++r) {
+      for(int c = 0; c < WIDTH; ++c) {
+        cells_written += game.get(r, c) != -1;
+      }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    writer.write(game, i);
+    write_time += seconds(start);
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool written = writer.close();
+  write_time += seconds(start);
+  if(!written) {
+    std::printf("writing %s failed\n", PATH);
+    std::remove(PATH);
+    return 1;
+  }
+
+  RecordFile file;
+  if(!file.open(PATH) || long(file.size()) != RECORDS) {
+    std::printf("cannot map %s\n", PATH);
+    std::remove(PATH);
+    return 1;
+  }
+  double mb = RecordFormat::stride(WIDTH, HEIGHT) * double(RECORDS) / 1048576.0;
+
+  // Cell by cell, as analysis code would look at a board.
+  long cells_got = 0;
+  long score = 0;
+  start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < file.size(); ++i) {
+    GameRecord record = file[i];
+    score += record.getScore();
+    for(int r = 0; r < HEIGHT + 4; ++r) {
+      for(int c = 0; c < WIDTH; ++c) {
+        cells_got += record.get(r, c) != -1;
+      }
+    }
+  }
+  double get_time = seconds(start);
+
+  // A byte at a time: count the non-zero nibbles.
+  long cells_scanned = 0;
+  size_t row_bytes = RecordFormat::rowBytes(WIDTH);
+  start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < file.size(); ++i) {
+    const unsigned char* row = file[i].getRowBytes(0);
+    for(size_t b = 0; b < row_bytes * (HEIGHT + 4); ++b) {
+      cells_scanned += (row[b] & 0x0f) != 0;
+      cells_scanned += (row[b] & 0xf0) != 0;
+    }
+  }
+  double scan_time = seconds(start);
+  benchSink += score;
+
+  file.close();
+  std::remove(PATH);
+
+  std::printf("%ld records of %dx%d, %zu bytes each, %.1f MB\n", RECORDS,
+              WIDTH, HEIGHT, RecordFormat::stride(WIDTH, HEIGHT), mb);
+  std::printf("%-12s %14s %10s\n", "", "records/sec", "MB/sec");
+  std::printf("%-12s %14.0f %10.0f\n", "write", RECORDS / write_time, mb / write_time);
+  std::printf("%-12s %14.0f %10.0f\n", "read get()", RECORDS / get_time, mb / get_time);
+  std::printf("%-12s %14.0f %10.0f\n", "read bytes", RECORDS / scan_time, mb / scan_time);
+
+  if(cells_got != cells_written || cells_scanned != cells_written
+     || score != RECORDS * (RECORDS - 1) / 2) {
+    std::printf("read back %ld and %ld cells, %ld written\n",
+                cells_got, cells_scanned, cells_written);
+    return 1;
+  }
+  return 0;
+}
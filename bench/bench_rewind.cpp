@@ -0,0 +1,171 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Rewind: an hour of play at 60 ticks a second recorded into a
+ * Timeline at several keyframe intervals, then sought to random ticks.
+ * Reports what recording costs per tick, the memory held and the
+ * seek latency, and checks every state sought against the one the
+ * game was in at that tick.  A last run under a small budget shows the
+ * history being bounded.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "game.h"
+#include "timeline.h"
+#include "bench.h"
+
+namespace {
+
+const long HOUR_TICKS = 60L * 60 * 60;
+const int SEEKS = 2000;
+const int PASSES = 5;
+
+// One hour-long session: the inputs of a careless player who steers
+// each piece to a random column and rotation, as tetris-sim's does,
+// starting over whenever the well fills.
+struct Session {
+  std::vector<unsigned char> inputs;
+  std::vector<uint64_t> hashes;
+};
+
+Session playSession()
+{
+  Session s;
+  Game game(10, 20, PieceSource(9));
+  std::mt19937 rng(9);
+  int target_x = 0;
+  int target_rotation = 0;
+  int last_y = -1;
+
+  s.hashes.push_back(hashGameState(game));
+  while(long(s.hashes.size()) <= HOUR_TICKS) {
+    if(game.getPieceY() > last_y) {
+      target_x = int(rng() % 10) - 1;
+      target_rotation = int(rng() % 4);
+    }
+
+    InputAction action = INPUT_DROP;
+    if(game.getPiece().getRotation() != target_rotation) {
+      action = INPUT_ROTATE_CW;
+    } else if(game.getPieceX() < target_x) {
+      action = INPUT_RIGHT;
+    } else if(game.getPieceX() > target_x) {
+      action = INPUT_LEFT;
+    }
+    if(!applyInput(game, action) && action != INPUT_DROP) {
+      s.inputs.push_back(action);
+      action = INPUT_DROP;
+      applyInput(game, action);
+    }
+    s.inputs.push_back(action);
+    last_y = game.getPieceY();
+
+    int rm = game.tick();
+    s.inputs.push_back(INPUT_TICK);
+    s.hashes.push_back(hashGameState(game));
+    if(rm < 0) {
+      game.reset();
+      s.inputs.push_back(INPUT_RESET);
+      last_y = -1;
+    }
+  }
+  return s;
+}
+
+// Replay the session's inputs on a fresh game, telling timeline about
+// each one if there is a timeline, and return the ns per tick taken.
+double replaySession(const Session& s, Timeline* timeline)
+{
+  typedef std::chrono::steady_clock clock;
+
+  Game game(10, 20, PieceSource(9));
+  clock::time_point start = clock::now();
+  for(unsigned char a : s.inputs) {
+    InputAction action = InputAction(a);
+    applyInput(game, action);
+    if(timeline) {
+      timeline->record(action, game);
+    }
+  }
+  return std::chrono::duration<double>(clock::now() - start).count()
+    * 1e9 / HOUR_TICKS;
+}
+
+int benchInterval(const Session& s, int interval, size_t budget)
+{
+  // What recording adds per tick: the best of several passes each
+  // way, taken in turn after a warm-up pass, so that neither side pays
+  // for cold caches or a slow moment alone.  Each recorded pass needs
+  // a timeline of its own, and the last is the one sought in.
+  replaySession(s, nullptr);
+  Game game(10, 20, PieceSource(9));
+  std::unique_ptr<Timeline> recording;
+  double plain = 0;
+  double recorded = 0;
+  for(int pass = 0; pass < PASSES; ++pass) {
+    double ns = replaySession(s, nullptr);
+    plain = pass == 0 ? ns : std::min(plain, ns);
+    recording.reset(new Timeline(game, budget, interval));
+    ns = replaySession(s, recording.get());
+    recorded = pass == 0 ? ns : std::min(recorded, ns);
+  }
+  const Timeline& timeline = *recording;
+  double record_ns = recorded - plain;
+
+  std::mt19937 rng(interval);
+  long first = timeline.getFirstTick();
+  long last = timeline.getLastTick();
+  std::vector<double> times;
+  times.reserve(SEEKS);
+  Game out(10, 20);
+  for(int i = 0; i < SEEKS; ++i) {
+    long tick = first + long(rng() % uint64_t(last - first + 1));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = timeline.seek(tick, out);
+    times.push_back(std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count() * 1e6);
+    if(!ok || hashGameState(out) != s.hashes[tick]) {
+      std::printf("interval %d: seek to tick %ld went wrong\n", interval, tick);
+      return 1;
+    }
+  }
+  std::sort(times.begin(), times.end());
+  double mean = 0;
+  for(double t : times) {
+    mean += t;
+  }
+  mean /= times.size();
+
+  std::printf("%8d %10ld %10.1f %8.1f %10.1f %10.1f %10.1f\n", interval, first,
+              timeline.getMemoryUsage() / 1048576.0, record_ns, mean,
+              times[times.size() / 2], times.back());
+  return 0;
+}
+
+} // namespace
+
+int runRewindBench()
+{
+  Session s = playSession();
+  std::printf("%ld ticks (an hour at 60/s), %zu inputs, 10x20\n",
+              HOUR_TICKS, s.inputs.size());
+  std::printf("%8s %10s %10s %8s %10s %10s %10s\n", "interval", "first",
+              "MB", "ns/tick", "seek mean", "median", "max us");
+
+  int failed = 0;
+  failed |= benchInterval(s, 16, size_t(1) << 30);
+  failed |= benchInterval(s, 64, size_t(1) << 30);
+  failed |= benchInterval(s, 256, size_t(1) << 30);
+  failed |= benchInterval(s, 1024, size_t(1) << 30);
+
+  std::printf("with a 1 MB budget:\n");
+  failed |= benchInterval(s, 256, size_t(1) << 20);
+  return failed;
+}
@@ -0,0 +1,114 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Forking search nodes: copying the whole Game for each child against
+ * restoring the parent's snapshot, playing the move and snapshotting
+ * the child, which shares every chunk of rows the move left alone, and
+ * against playing the move on the parent and undoing it.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "arena.h"
+#include "game.h"
+#include "bench.h"
+
+namespace {
+
+// Children per round; the arena is cleared between rounds, as a
+// search would between moves.
+const int CHILDREN = 256;
+
+// The move that makes child i: slide and drop the falling piece.
+void playChild(Game& game, int i)
+{
+  if(i & 1) {
+    game.moveLeft();
+  } else {
+    game.moveRight();
+  }
+  game.drop();
+  game.tick();
+}
+
+int benchWell(int width, int height)
+{
+  Game parent(width, height);
+  fillGarbage(parent, std::min(height / 2, 16), 0.6, 42);
+
+  SnapshotArena arena;
+  Game child(parent);
+
+  // Both ways of forking must land in the same place.
+  for(int i = 0; i < 4; ++i) {
+    GameSnapshot base = parent.snapshot(arena);
+    Game copy(parent);
+    playChild(copy, i);
+    child.restore(base);
+    playChild(child, i);
+    for(int r = 0; r < height + 4; ++r) {
+      for(int c = 0; c < width; ++c) {
+        if(copy.get(r, c) != child.get(r, c)) {
+          std::printf("%dx%d: forks disagree\n", width, height);
+          return 1;
+        }
+      }
+    }
+  }
+
+  long sink = 0;
+  double before = measureRate([&]() {
+    for(int i = 0; i < CHILDREN; ++i) {
+      Game copy(parent);
+      playChild(copy, i);
+      sink += copy.getPieceY();
+    }
+  }, CHILDREN);
+
+  size_t bytes = 0;
+  double after = measureRate([&]() {
+    arena.clear();
+    GameSnapshot base = parent.snapshot(arena);
+    for(int i = 0; i < CHILDREN; ++i) {
+      child.restore(base);
+      playChild(child, i);
+      sink += child.snapshot(arena).py;
+    }
+    bytes = arena.bytesUsed();
+  }, CHILDREN);
+
+  Game journaled(parent);
+  journaled.setJournaling(true);
+  double undo = measureRate([&]() {
+    for(int i = 0; i < CHILDREN; ++i) {
+      playChild(journaled, i);
+      sink += journaled.getPieceY();
+      while(journaled.undo()) {
+      }
+    }
+  }, CHILDREN);
+  benchSink = sink;
+
+  std::printf("%5dx%-5d %14.0f %14.0f %14.0f %8.2fx %10zu\n",
+              width, height, before, after, undo, after / before,
+              bytes / (CHILDREN + 1));
+  return 0;
+}
+
+} // namespace
+
+int runSnapshotBench()
+{
+  std::printf("search nodes forked/sec\n");
+  std::printf("%-11s %14s %14s %14s %9s %10s\n",
+              "well", "copy", "snapshot", "undo", "speedup", "bytes/node");
+
+  int failed = 0;
+  failed |= benchWell(10, 20);
+  failed |= benchWell(10, 1000);
+  failed |= benchWell(10, 10000);
+  failed |= benchWell(1000, 1000);
+  return failed;
+}
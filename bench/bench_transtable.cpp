@@ -0,0 +1,130 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Transposition table throughput: probes (and stores on a miss) per
+ * second from 1 up to every hardware thread, and what the table buys
+ * the autoplayer's search.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bot.h"
+#include "game.h"
+#include "heuristic.h"
+#include "transtable.h"
+#include "workpool.h"
+#include "bench.h"
+
+namespace {
+
+const int TABLE_BITS = 20;
+// Distinct keys looked up; about half the table, so most probes hit
+// once it has warmed up.
+const int KEYS = 1 << 19;
+const long OPS = 1 << 23;
+
+uint64_t keyFor(long i)
+{
+  uint64_t z = uint64_t(i % KEYS) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  return z ^ (z >> 31);
+}
+
+double tableRate(TranspositionTable& table, int threads)
+{
+  WorkPool pool(threads);
+  std::vector<long> sink(pool.size(), 0);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  pool.run(OPS, [&](long i, int worker) {
+    uint64_t key = keyFor(i * 7919);
+    double value;
+    if(table.probe(key, value)) {
+      sink[worker] += long(value);
+    } else {
+      table.store(key, double(i));
+    }
+  });
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  for(size_t i = 0; i < sink.size(); ++i) {
+    benchSink = benchSink + sink[i];
+  }
+  return OPS / elapsed;
+}
+
+// Pieces the bot places in a row, timed.
+double botRate(TranspositionTable* table, double& hit_rate, long& lines)
+{
+  const int PIECES = 300;
+  Game game(10, 20, PieceSource(1, PieceSource::BAG, 2));
+  WeightedHeuristic heuristic;
+  Bot bot(heuristic, 16, 2);
+  bot.setTranspositionTable(table);
+
+  lines = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int i = 0; i < PIECES; ++i) {
+    int rm = bot.play(game);
+    if(rm < 0) {
+      break;
+    }
+    lines += rm;
+  }
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  hit_rate = table ? table->getHitRate() : 0.0;
+  return bot.getPlacementsScored() / elapsed;
+}
+
+} // namespace
+
+int runTranspositionBench()
+{
+  TranspositionTable table(TABLE_BITS);
+  int max_threads = int(std::thread::hardware_concurrency());
+  if(max_threads < 1) {
+    max_threads = 1;
+  }
+
+  std::printf("table probes/sec, 2^%d slots\n", TABLE_BITS);
+  std::printf("%7s %14s %9s\n", "threads", "probes/sec", "hit rate");
+  for(int t = 1; ; t = t * 2 < max_threads ? t * 2 : max_threads) {
+    table.clear();
+    table.resetCounters();
+    double rate = tableRate(table, t);
+    std::printf("%7d %14.0f %8.1f%%\n", t, rate, 100.0 * table.getHitRate());
+    if(t == max_threads) {
+      break;
+    }
+  }
+
+  std::printf("\nautoplayer placements scored/sec, beam 16, lookahead 2\n");
+  std::printf("%-10s %14s %9s\n", "table", "placements/s", "hit rate");
+
+  double hits;
+  long plain_lines;
+  long table_lines;
+  double plain = botRate(nullptr, hits, plain_lines);
+  std::printf("%-10s %14.0f %9s\n", "off", plain, "-");
+
+  table.clear();
+  table.resetCounters();
+  double shared = botRate(&table, hits, table_lines);
+  std::printf("%-10s %14.0f %8.1f%%\n", "on", shared, 100.0 * hits);
+
+  // Hits hand back exactly what the heuristic would have said, so the
+  // game must play out the same.
+  if(plain_lines != table_lines) {
+    std::printf("games disagree: %ld lines without the table, %ld with\n",
+                plain_lines, table_lines);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * CellWell - the original int-per-cell well, its collision test and
+ * its line clearing, kept as the "before" column of the benchmarks.
+ */
+
+#ifndef CELLWELL_H
+#define CELLWELL_H
+
+#include <vector>
+
+#include "game.h"
+
+class CellWell {
+public:
+  CellWell(const Game& game)
+    : width_(game.getWidth())
+    , height_(game.getHeight())
+    , cells_(game.getWidth() * (game.getHeight()+4))
+  {
+    for(int r = 0; r < height_ + 4; ++r) {
+      for(int c = 0; c < width_; ++c) {
+        set(r, c, game.get(r, c));
+      }
+    }
+  }
+
+  int get(int r, int c) const
+  {
+    return cells_[ r*width_ + c ];
+  }
+  void set(int r, int c, int value)
+  {
+    cells_[ r*width_ + c ] = value;
+  }
+
+  bool doesPieceFit(const Piece& p, int x, int y) const
+  {
+    if(x + p.getLeftMargin() < 0) {
+      return false;
+    }
+    if(x + 3 - p.getRightMargin() >= width_) {
+      return false;
+    }
+    if(y + p.getBottomMargin() < 3) {
+      return false;
+    }
+
+    for(int r = 0; r < 4; ++r) {
+      for(int c = 0; c < 4; ++c) {
+        if(p.isOn(r, c)) {
+          if(get(y-r, x+c) != -1) {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void removeRow(int y)
+  {
+    for(int r = y + 1; r < height_ + 4; ++r) {
+      for(int c = 0; c < width_; ++c) {
+        set(r-1, c, get(r, c));
+      }
+    }
+
+    for(int c = 0; c < width_; ++c) {
+      set(height_+3, c, -1);
+    }
+  }
+
+  int collapse()
+  {
+    int removed = 0;
+
+    while(true) {
+      bool got_one = false;
+      for(int r = 0; r < height_ + 4; ++r) {
+        int holes = 0;
+
+        for(int c = 0; c < width_; ++c) {
+          if(get(r, c) == -1) {
+            holes = 1;
+            break;
+          }
+        }
+
+        if(holes == 0) {
+          got_one = 1;
+          ++removed;
+          removeRow(r);
+          break;
+        }
+      }
+
+      if(!got_one) {
+        break;
+      }
+    }
+
+    return removed;
+  }
+
+private:
+  int width_;
+  int height_;
+  std::vector<int> cells_;
+};
+
+#endif // CELLWELL_H
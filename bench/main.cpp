@@ -0,0 +1,86 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * tetris-bench - throughput benchmarks for the game engine.
+ *
+ *   tetris-bench [scenario...]         before/after comparisons
+ *   tetris-bench --json [file]         microbenchmark suite as JSON
+ *   tetris-bench --compare baseline.json [--threshold percent]
+ *                                      suite against a stored baseline
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "game.h"
+#include "bench.h"
+
+volatile long benchSink;
+
+void fillGarbage(Game& game, int fill_rows, double density, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+  for(int r = 0; r < fill_rows; ++r) {
+    for(int c = 0; c < game.getWidth(); ++c) {
+      game.set(r, c, coin(rng) < density ? int(rng() % 7) : -1);
+    }
+    // Garbage never clears on its own.
+    game.set(r, rng() % game.getWidth(), -1);
+  }
+}
+
+struct Scenario {
+  const char* name;
+  int (*run)();
+};
+
+static const Scenario SCENARIOS[] = {
+  { "collision", runCollisionBench },
+  { "collapse", runCollapseBench },
+  { "drop", runDropBench },
+  { "snapshot", runSnapshotBench },
+  { "transposition", runTranspositionBench },
+  { "batch", runBatchBench },
+  { "eval", runEvalBench },
+  { "fixed", runFixedBench },
+  { "huge", runHugeBench },
+  { "cells", runCellsBench },
+  { "rewind", runRewindBench },
+  { "records", runRecordsBench },
+};
+
+int main(int argc, char *argv[])
+{
+  if(argc >= 2 && std::strcmp(argv[1], "--json") == 0) {
+    return runSuite(argc >= 3 ? argv[2] : nullptr);
+  }
+
+  if(argc >= 3 && std::strcmp(argv[1], "--compare") == 0) {
+    double threshold = 10.0;
+    if(argc >= 5 && std::strcmp(argv[3], "--threshold") == 0) {
+      threshold = std::atof(argv[4]);
+    }
+    return compareSuite(argv[2], threshold);
+  }
+
+  int count = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+  int failed = 0;
+
+  for(int i = 0; i < count; ++i) {
+    bool wanted = argc < 2;
+    for(int a = 1; a < argc; ++a) {
+      wanted = wanted || std::strcmp(argv[a], SCENARIOS[i].name) == 0;
+    }
+    if(wanted) {
+      failed |= SCENARIOS[i].run();
+      std::printf("\n");
+    }
+  }
+
+  return failed;
+}
@@ -0,0 +1,331 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * The microbenchmark suite: every engine hot path on a fixed set of
+ * seeded board states, reported as JSON and optionally checked against
+ * a stored baseline.
+ *
+ * Operations that change the game are timed across a batch of games
+ * that all start from the same state, one call each, and the games
+ * are reloaded between batches outside the timed region.  That way
+ * every call sees the state it is named after.  Each benchmark keeps
+ * the best of several rounds, which is far steadier than the mean when
+ * comparing against a baseline.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "bench.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Fixture {
+  const char *name;
+  int width;
+  int height;
+  int fill_rows;
+};
+
+const Fixture FIXTURES[] = {
+  { "empty",       10,    20,    0 },
+  { "half",        10,    20,   10 },
+  { "nearly-full", 10,    20,   18 },
+  { "tall",        10, 10000, 5000 },
+  { "wide",      1000,    40,   20 },
+};
+
+struct Result {
+  std::string name;
+  std::string state;
+  double ns_per_op;
+};
+
+const int ROUNDS = 5;
+const double MIN_SECONDS = 0.02;
+const double MAX_WALL_SECONDS = 0.1;
+
+// The garbage for a fixture, generated once and then copied in.
+std::vector<int> garbageFor(const Fixture& f)
+{
+  Game source(f.width, f.height);
+  fillGarbage(source, f.fill_rows, 0.6, 42);
+
+  std::vector<int> cells;
+  for(int r = 0; r < f.fill_rows; ++r) {
+    for(int c = 0; c < f.width; ++c) {
+      cells.push_back(source.get(r, c));
+    }
+  }
+  return cells;
+}
+
+void loadFixture(Game& game, const Fixture& f, const std::vector<int>& garbage,
+                 int full_rows)
+{
+  game.reset(42);
+  for(int r = 0; r < std::max(f.fill_rows, full_rows); ++r) {
+    for(int c = 0; c < f.width; ++c) {
+      game.set(r, c, r < full_rows ? 0 : garbage[ r*f.width + c ]);
+    }
+  }
+}
+
+// Apply op once to each game of a batch loaded with fixture f,
+// reloading between batches, and return the mean time per call.
+template <typename Op>
+double timeBatched(const Fixture& f, int full_rows, Op op)
+{
+  std::vector<int> garbage = garbageFor(f);
+  int batch = std::max(4, std::min(64, 200000 / (f.width * f.height)));
+  std::vector<std::unique_ptr<Game> > games;
+  for(int i = 0; i < batch; ++i) {
+    games.push_back(std::unique_ptr<Game>(new Game(f.width, f.height)));
+  }
+
+  double best = 0;
+  long sink = 0;
+
+  for(int round = 0; round < ROUNDS; ++round) {
+    double timed = 0;
+    long calls = 0;
+    Clock::time_point wall_start = Clock::now();
+
+    while(timed < MIN_SECONDS &&
+          std::chrono::duration<double>(Clock::now() - wall_start).count() < MAX_WALL_SECONDS) {
+      for(int i = 0; i < batch; ++i) {
+        loadFixture(*games[i], f, garbage, full_rows);
+      }
+
+      Clock::time_point start = Clock::now();
+      for(int i = 0; i < batch; ++i) {
+        sink += op(*games[i]);
+      }
+      timed += std::chrono::duration<double>(Clock::now() - start).count();
+      calls += batch;
+    }
+
+    double ns = timed * 1e9 / calls;
+    best = round == 0 ? ns : std::min(best, ns);
+  }
+
+  benchSink = sink;
+  return best;
+}
+
+// Call op over and over on one game that it does not change.
+template <typename Op>
+double timeHot(Op op, long ops_per_call)
+{
+  double best = 0;
+  for(int round = 0; round < ROUNDS; ++round) {
+    double ns = 1e9 / measureRate(op, ops_per_call, MIN_SECONDS);
+    best = round == 0 ? ns : std::min(best, ns);
+  }
+  return best;
+}
+
+void runFixture(const Fixture& f, std::vector<Result>& results)
+{
+  struct Timing {
+    const char *name;
+    double ns;
+  };
+  std::vector<Timing> timings;
+
+  timings.push_back(Timing{ "tick", timeBatched(f, 0, [](Game& g) {
+    return g.tick();
+  }) });
+  timings.push_back(Timing{ "drop", timeBatched(f, 0, [](Game& g) {
+    return int(g.drop());
+  }) });
+  timings.push_back(Timing{ "moveLeft", timeBatched(f, 0, [](Game& g) {
+    return int(g.moveLeft());
+  }) });
+  timings.push_back(Timing{ "moveRight", timeBatched(f, 0, [](Game& g) {
+    return int(g.moveRight());
+  }) });
+  timings.push_back(Timing{ "rotateCW", timeBatched(f, 0, [](Game& g) {
+    return int(g.rotateCW());
+  }) });
+  timings.push_back(Timing{ "rotateCCW", timeBatched(f, 0, [](Game& g) {
+    return int(g.rotateCCW());
+  }) });
+  timings.push_back(Timing{ "collapse", timeBatched(f, 4, [](Game& g) {
+    return GameProbe::collapse(g);
+  }) });
+
+  // Collision probes spread over the whole well, in every orientation.
+  Game game(f.width, f.height);
+  loadFixture(game, f, garbageFor(f), 0);
+  std::mt19937 rng(7);
+  std::vector<Piece> pieces(1024);
+  std::vector<int> xs(pieces.size());
+  std::vector<int> ys(pieces.size());
+  for(size_t i = 0; i < pieces.size(); ++i) {
+    pieces[i] = Piece(rng() % 7, rng() % 4);
+    xs[i] = int(rng() % (f.width + 2)) - 1;
+    ys[i] = 3 + int(rng() % (f.height + 1));
+  }
+
+  long sink = 0;
+  timings.push_back(Timing{ "doesPieceFit", timeHot([&]() {
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      sink += game.doesPieceFit(pieces[i], xs[i], ys[i]);
+    }
+  }, pieces.size()) });
+  timings.push_back(Timing{ "Piece::rotateCW", timeHot([&]() {
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      pieces[i] = pieces[i].rotateCW();
+      sink += pieces[i].getRotation();
+    }
+  }, pieces.size()) });
+  std::vector<Placement> placements;
+  timings.push_back(Timing{ "enumeratePlacements", timeHot([&]() {
+    game.enumeratePlacements(placements);
+    sink += placements.size();
+  }, 1) });
+  benchSink = sink;
+
+  char state[64];
+  std::snprintf(state, sizeof(state), "%s-%dx%d", f.name, f.width, f.height);
+  for(size_t i = 0; i < timings.size(); ++i) {
+    results.push_back(Result{ timings[i].name, state, timings[i].ns });
+  }
+}
+
+void writeJson(std::FILE *out, const std::vector<Result>& results)
+{
+  // One benchmark per line, so the baseline reader can stay simple.
+  std::fprintf(out, "{\n  \"benchmarks\": [\n");
+  for(size_t i = 0; i < results.size(); ++i) {
+    std::fprintf(out,
+                 "    {\"name\": \"%s\", \"state\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_sec\": %.0f}%s\n",
+                 results[i].name.c_str(), results[i].state.c_str(),
+                 results[i].ns_per_op, 1e9 / results[i].ns_per_op,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(out, "  ]\n}\n");
+}
+
+// Pull the string value of "key" out of one line of our own JSON.
+bool readField(const char *line, const char *key, std::string& value)
+{
+  std::string pattern = std::string("\"") + key + "\": ";
+  const char *p = std::strstr(line, pattern.c_str());
+  if(!p) {
+    return false;
+  }
+  p += pattern.size();
+
+  if(*p == '"') {
+    const char *end = std::strchr(++p, '"');
+    if(!end) {
+      return false;
+    }
+    value.assign(p, end);
+  } else {
+    value.assign(p, p + std::strcspn(p, ",}"));
+  }
+  return true;
+}
+
+bool readBaseline(const char *path, std::vector<Result>& baseline)
+{
+  std::FILE *in = std::fopen(path, "r");
+  if(!in) {
+    return false;
+  }
+
+  char line[512];
+  while(std::fgets(line, sizeof(line), in)) {
+    Result r;
+    std::string ns;
+    if(readField(line, "name", r.name) && readField(line, "state", r.state) &&
+       readField(line, "ns_per_op", ns)) {
+      r.ns_per_op = std::atof(ns.c_str());
+      baseline.push_back(r);
+    }
+  }
+
+  std::fclose(in);
+  return true;
+}
+
+std::vector<Result> runAll()
+{
+  std::vector<Result> results;
+  for(size_t i = 0; i < sizeof(FIXTURES) / sizeof(FIXTURES[0]); ++i) {
+    runFixture(FIXTURES[i], results);
+  }
+  return results;
+}
+
+} // namespace
+
+int runSuite(const char *json_path)
+{
+  std::vector<Result> results = runAll();
+
+  std::FILE *out = json_path ? std::fopen(json_path, "w") : stdout;
+  if(!out) {
+    std::perror(json_path);
+    return 1;
+  }
+  writeJson(out, results);
+  if(out != stdout) {
+    std::fclose(out);
+  }
+  return 0;
+}
+
+int compareSuite(const char *baseline_path, double threshold)
+{
+  std::vector<Result> baseline;
+  if(!readBaseline(baseline_path, baseline)) {
+    std::perror(baseline_path);
+    return 1;
+  }
+
+  std::vector<Result> results = runAll();
+  int regressions = 0;
+
+  std::printf("%-20s %-22s %12s %12s %9s\n", "benchmark", "state",
+              "base ns/op", "ns/op", "change");
+  for(size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    const Result *base = nullptr;
+    for(size_t j = 0; j < baseline.size(); ++j) {
+      if(baseline[j].name == r.name && baseline[j].state == r.state) {
+        base = &baseline[j];
+      }
+    }
+
+    if(!base) {
+      std::printf("%-20s %-22s %12s %12.2f %9s\n", r.name.c_str(),
+                  r.state.c_str(), "-", r.ns_per_op, "new");
+      continue;
+    }
+
+    double change = (r.ns_per_op / base->ns_per_op - 1.0) * 100.0;
+    bool regressed = change > threshold;
+    regressions += regressed;
+    std::printf("%-20s %-22s %12.2f %12.2f %+8.1f%%%s\n", r.name.c_str(),
+                r.state.c_str(), base->ns_per_op, r.ns_per_op, change,
+                regressed ? "  REGRESSION" : "");
+  }
+
+  std::printf("\n%d regression(s) beyond %.0f%%\n", regressions, threshold);
+  return regressions > 0;
+}
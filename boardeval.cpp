@@ -0,0 +1,628 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Board evaluation kernel - board features from row bitmasks, with
+ * AVX2, SSE2 and scalar paths picked at run time.
+ */
+
+#include <algorithm>
+
+#include "boardeval.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EVAL_X86 1
+#include <immintrin.h>
+#define EVAL_TARGET(isa) __attribute__((target(isa)))
+// GCC will not inline across target attributes on its own judgement,
+// and a call passing vectors through memory costs more than the work.
+#define EVAL_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace {
+
+// Lanes of one board's rows are evaluated in blocks of this many rows,
+// so their covers fit on the stack.
+const int BLOCK_ROWS = 256;
+
+// Constants for a well of one width.
+struct Masks {
+  // The columns of the well.
+  uint64_t full;
+  // Columns with a neighbour to the right.
+  uint64_t adj;
+  // The rightmost column, bit shift of it.
+  uint64_t top;
+  int shift;
+  // Columns that can hold a well; none if the well is one column wide,
+  // as then both its neighbours are walls.
+  uint64_t well;
+};
+
+Masks makeMasks(int width)
+{
+  Masks m;
+  m.full = width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+  m.adj = m.full >> 1;
+  m.shift = width - 1;
+  m.top = uint64_t(1) << m.shift;
+  m.well = width > 1 ? m.full : 0;
+  return m;
+}
+
+// Running totals of each feature's bit counts.
+struct Sums {
+  uint64_t aggregate_height;
+  uint64_t max_height;
+  uint64_t holes;
+  uint64_t bumpiness;
+  uint64_t wells;
+  uint64_t row_transitions;
+  uint64_t column_transitions;
+};
+
+// lanes rows were summed, some maybe empty padding.  Every empty row
+// above the stack added its two wall transitions, which do not count.
+void finish(const Sums& s, int lanes, BoardEval& out)
+{
+  out.aggregate_height = int(s.aggregate_height);
+  out.max_height = int(s.max_height);
+  out.holes = int(s.holes);
+  out.bumpiness = int(s.bumpiness);
+  out.wells = int(s.wells);
+  out.row_transitions = int(s.row_transitions) - 2 * (lanes - out.max_height);
+  out.column_transitions = int(s.column_transitions);
+}
+
+// The builtin is only one instruction when the compiler may assume
+// POPCNT; otherwise it is a library call, slower than counting by
+// halves.
+inline int popcount(uint64_t x)
+{
+#if defined(__POPCNT__) || (defined(__GNUC__) && !defined(EVAL_X86))
+  return __builtin_popcountll(x);
+#else
+  x -= (x >> 1) & 0x5555555555555555ULL;
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return int((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// -- scalar ---------------------------------------------------------
+
+inline void accumulate(uint64_t row, uint64_t below, uint64_t cov,
+                       const Masks& m, Sums& s)
+{
+  s.aggregate_height += popcount(cov);
+  s.max_height += cov != 0;
+  s.holes += popcount(cov & ~row);
+  s.bumpiness += popcount((cov ^ (cov >> 1)) & m.adj);
+  s.wells += popcount(~cov & m.well & ((cov << 1) | 1) & ((cov >> 1) | m.top));
+  // An empty edge column meets its wall; in a well one column wide
+  // the column meets both.
+  s.row_transitions += popcount((row ^ (row >> 1)) & m.adj)
+    + (~row & 1) + ((~row & m.top) >> m.shift);
+  s.column_transitions += popcount((row ^ below) & m.full);
+}
+
+void boardScalar(const uint64_t* rows, int count, const Masks& m,
+                 BoardEval& out)
+{
+  Sums s = Sums();
+  uint64_t cov = 0;
+  for(int r = count - 1; r >= 0; --r) {
+    uint64_t row = rows[r] & m.full;
+    uint64_t below = r > 0 ? rows[r-1] & m.full : m.full;
+    cov |= row;
+    accumulate(row, below, cov, m, s);
+  }
+  finish(s, count, out);
+}
+
+void batchScalar(const uint64_t* rows, int stride, int boards, int count,
+                 const Masks& m, BoardEval* out)
+{
+  for(int b = 0; b < boards; ++b) {
+    boardScalar(rows + size_t(b) * stride, count, m, out[b]);
+  }
+}
+
+// Lay out one block of a board's rows [lo,hi) for the vector paths:
+// each row, the row below it and the row's cover, carried down from
+// the rows above in cov.  Returns the block's length.
+inline int fillBlock(const uint64_t* rows, int lo, int hi, const Masks& m,
+              uint64_t& cov, uint64_t* row, uint64_t* below, uint64_t* cover)
+{
+  for(int r = hi - 1; r >= lo; --r) {
+    row[r-lo] = rows[r] & m.full;
+    below[r-lo] = r > 0 ? rows[r-1] & m.full : m.full;
+    cov |= row[r-lo];
+    cover[r-lo] = cov;
+  }
+  return hi - lo;
+}
+
+#ifdef EVAL_X86
+
+// The vector paths count bits a byte at a time and add the bytes up
+// for FLUSH_STEPS steps before summing them into 64-bit totals.  One
+// step adds at most 10 to a byte, so none can overflow before then.
+const int FLUSH_STEPS = 16;
+
+// Board i's totals are lane i of sums; add n lanes up for one board.
+Sums addLanes(const Sums* sums, int n)
+{
+  Sums total = Sums();
+  for(int i = 0; i < n; ++i) {
+    total.aggregate_height += sums[i].aggregate_height;
+    total.max_height += sums[i].max_height;
+    total.holes += sums[i].holes;
+    total.bumpiness += sums[i].bumpiness;
+    total.wells += sums[i].wells;
+    total.row_transitions += sums[i].row_transitions;
+    total.column_transitions += sums[i].column_transitions;
+  }
+  return total;
+}
+
+// -- SSE2: two lanes ------------------------------------------------
+
+struct Vec128 {
+  __m128i aggregate_height;
+  __m128i max_height;
+  __m128i holes;
+  __m128i bumpiness;
+  __m128i wells;
+  __m128i row_transitions;
+  __m128i column_transitions;
+};
+
+// Bits set in each byte.  SSE2 has no byte shuffle, so they are
+// counted by halving.
+EVAL_TARGET("sse2") EVAL_INLINE __m128i popcount128(__m128i v)
+{
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0f);
+  v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+  v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+  return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+}
+
+EVAL_TARGET("sse2") EVAL_INLINE void accumulate128(__m128i row, __m128i below,
+                                                   __m128i cov, const Masks& m,
+                                                   Vec128& s)
+{
+  const __m128i full = _mm_set1_epi64x(m.full);
+  const __m128i adj = _mm_set1_epi64x(m.adj);
+  const __m128i top = _mm_set1_epi64x(m.top);
+  const __m128i well = _mm_set1_epi64x(m.well);
+  const __m128i one = _mm_set1_epi64x(1);
+  const __m128i shift = _mm_cvtsi32_si128(m.shift);
+
+  // A lane's cover is non-zero exactly when cov | -cov has its top
+  // bit set.
+  __m128i nz = _mm_or_si128(cov, _mm_sub_epi64(_mm_setzero_si128(), cov));
+
+  s.aggregate_height = _mm_add_epi8(s.aggregate_height, popcount128(cov));
+  s.max_height = _mm_add_epi8(s.max_height, _mm_srli_epi64(nz, 63));
+  s.holes = _mm_add_epi8(s.holes, popcount128(_mm_andnot_si128(row, cov)));
+  s.bumpiness = _mm_add_epi8(s.bumpiness, popcount128(
+    _mm_and_si128(_mm_xor_si128(cov, _mm_srli_epi64(cov, 1)), adj)));
+  s.wells = _mm_add_epi8(s.wells, popcount128(_mm_and_si128(
+    _mm_andnot_si128(cov, well),
+    _mm_and_si128(_mm_or_si128(_mm_slli_epi64(cov, 1), one),
+                  _mm_or_si128(_mm_srli_epi64(cov, 1), top)))));
+  s.row_transitions = _mm_add_epi8(s.row_transitions, _mm_add_epi8(
+    popcount128(_mm_and_si128(_mm_xor_si128(row, _mm_srli_epi64(row, 1)), adj)),
+    _mm_add_epi8(_mm_andnot_si128(row, one),
+                 _mm_srl_epi64(_mm_andnot_si128(row, top), shift))));
+  s.column_transitions = _mm_add_epi8(s.column_transitions, popcount128(
+    _mm_and_si128(_mm_xor_si128(row, below), full)));
+}
+
+EVAL_TARGET("sse2") void zero128(Vec128& s)
+{
+  s.aggregate_height = s.max_height = s.holes = s.bumpiness = s.wells =
+    s.row_transitions = s.column_transitions = _mm_setzero_si128();
+}
+
+// Sum the byte counts in bytes into each lane's totals, by
+// sum-of-differences against zero, and start the bytes again.
+EVAL_TARGET("sse2") void flush128(Vec128& bytes, Vec128& totals)
+{
+  const __m128i zero = _mm_setzero_si128();
+  totals.aggregate_height = _mm_add_epi64(totals.aggregate_height,
+                                          _mm_sad_epu8(bytes.aggregate_height, zero));
+  totals.max_height = _mm_add_epi64(totals.max_height,
+                                    _mm_sad_epu8(bytes.max_height, zero));
+  totals.holes = _mm_add_epi64(totals.holes, _mm_sad_epu8(bytes.holes, zero));
+  totals.bumpiness = _mm_add_epi64(totals.bumpiness,
+                                   _mm_sad_epu8(bytes.bumpiness, zero));
+  totals.wells = _mm_add_epi64(totals.wells, _mm_sad_epu8(bytes.wells, zero));
+  totals.row_transitions = _mm_add_epi64(totals.row_transitions,
+                                         _mm_sad_epu8(bytes.row_transitions, zero));
+  totals.column_transitions = _mm_add_epi64(totals.column_transitions,
+                                            _mm_sad_epu8(bytes.column_transitions, zero));
+  zero128(bytes);
+}
+
+// Lane i of each total into sums[i].
+EVAL_TARGET("sse2") void lanes128(const Vec128& s, Sums* sums)
+{
+  alignas(16) uint64_t v[7][2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[0]), s.aggregate_height);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[1]), s.max_height);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[2]), s.holes);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[3]), s.bumpiness);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[4]), s.wells);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[5]), s.row_transitions);
+  _mm_store_si128(reinterpret_cast<__m128i*>(v[6]), s.column_transitions);
+  for(int i = 0; i < 2; ++i) {
+    sums[i].aggregate_height = v[0][i];
+    sums[i].max_height = v[1][i];
+    sums[i].holes = v[2][i];
+    sums[i].bumpiness = v[3][i];
+    sums[i].wells = v[4][i];
+    sums[i].row_transitions = v[5][i];
+    sums[i].column_transitions = v[6][i];
+  }
+}
+
+// One board, its rows two to a vector.  A padding lane is an empty
+// row with nothing above or below it.
+EVAL_TARGET("sse2") void boardSSE2(const uint64_t* rows, int count,
+                                   const Masks& m, BoardEval& out)
+{
+  alignas(16) uint64_t row[BLOCK_ROWS + 1];
+  alignas(16) uint64_t below[BLOCK_ROWS + 1];
+  alignas(16) uint64_t cover[BLOCK_ROWS + 1];
+
+  Vec128 bytes;
+  Vec128 totals;
+  zero128(bytes);
+  zero128(totals);
+  uint64_t cov = 0;
+  int lanes = 0;
+  int steps = 0;
+  for(int hi = count; hi > 0; hi -= BLOCK_ROWS) {
+    int n = fillBlock(rows, std::max(hi - BLOCK_ROWS, 0), hi, m, cov,
+                      row, below, cover);
+    if(n & 1) {
+      row[n] = below[n] = cover[n] = 0;
+      ++n;
+    }
+    for(int i = 0; i < n; i += 2) {
+      accumulate128(_mm_load_si128(reinterpret_cast<const __m128i*>(row + i)),
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(below + i)),
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(cover + i)),
+                    m, bytes);
+      if(++steps == FLUSH_STEPS) {
+        flush128(bytes, totals);
+        steps = 0;
+      }
+    }
+    lanes += n;
+  }
+  flush128(bytes, totals);
+
+  Sums sums[2];
+  lanes128(totals, sums);
+  finish(addLanes(sums, 2), lanes, out);
+}
+
+// Boards two at a time, one per lane, walking their rows together.
+EVAL_TARGET("sse2") void batchSSE2(const uint64_t* rows, int stride, int boards,
+                                   int count, const Masks& m, BoardEval* out)
+{
+  const __m128i full = _mm_set1_epi64x(m.full);
+  int b = 0;
+  for(; b + 2 <= boards; b += 2) {
+    const uint64_t* r0 = rows + size_t(b) * stride;
+    const uint64_t* r1 = r0 + stride;
+
+    Vec128 bytes;
+    Vec128 totals;
+    zero128(bytes);
+    zero128(totals);
+    __m128i cov = _mm_setzero_si128();
+    __m128i row = _mm_and_si128(_mm_set_epi64x(r1[count-1], r0[count-1]), full);
+    for(int r = count - 1, steps = 0; r >= 0; --r) {
+      __m128i below = r > 0 ? _mm_and_si128(_mm_set_epi64x(r1[r-1], r0[r-1]), full)
+                            : full;
+      cov = _mm_or_si128(cov, row);
+      accumulate128(row, below, cov, m, bytes);
+      if(++steps == FLUSH_STEPS) {
+        flush128(bytes, totals);
+        steps = 0;
+      }
+      row = below;
+    }
+    flush128(bytes, totals);
+
+    Sums sums[2];
+    lanes128(totals, sums);
+    finish(sums[0], count, out[b]);
+    finish(sums[1], count, out[b+1]);
+  }
+  batchScalar(rows + size_t(b) * stride, stride, boards - b, count, m, out + b);
+}
+
+// -- AVX2: four lanes -----------------------------------------------
+
+struct Vec256 {
+  __m256i aggregate_height;
+  __m256i max_height;
+  __m256i holes;
+  __m256i bumpiness;
+  __m256i wells;
+  __m256i row_transitions;
+  __m256i column_transitions;
+};
+
+// Bits set in each byte: each nibble looked up in a table by byte
+// shuffle.
+EVAL_TARGET("avx2") EVAL_INLINE __m256i popcount256(__m256i v)
+{
+  const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+  __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+  return _mm256_add_epi8(lo, hi);
+}
+
+EVAL_TARGET("avx2") EVAL_INLINE void accumulate256(__m256i row, __m256i below,
+                                                   __m256i cov, const Masks& m,
+                                                   Vec256& s)
+{
+  const __m256i full = _mm256_set1_epi64x(m.full);
+  const __m256i adj = _mm256_set1_epi64x(m.adj);
+  const __m256i top = _mm256_set1_epi64x(m.top);
+  const __m256i well = _mm256_set1_epi64x(m.well);
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m128i shift = _mm_cvtsi32_si128(m.shift);
+
+  __m256i nz = _mm256_or_si256(cov, _mm256_sub_epi64(_mm256_setzero_si256(), cov));
+
+  s.aggregate_height = _mm256_add_epi8(s.aggregate_height, popcount256(cov));
+  s.max_height = _mm256_add_epi8(s.max_height, _mm256_srli_epi64(nz, 63));
+  s.holes = _mm256_add_epi8(s.holes, popcount256(_mm256_andnot_si256(row, cov)));
+  s.bumpiness = _mm256_add_epi8(s.bumpiness, popcount256(
+    _mm256_and_si256(_mm256_xor_si256(cov, _mm256_srli_epi64(cov, 1)), adj)));
+  s.wells = _mm256_add_epi8(s.wells, popcount256(_mm256_and_si256(
+    _mm256_andnot_si256(cov, well),
+    _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi64(cov, 1), one),
+                     _mm256_or_si256(_mm256_srli_epi64(cov, 1), top)))));
+  s.row_transitions = _mm256_add_epi8(s.row_transitions, _mm256_add_epi8(
+    popcount256(_mm256_and_si256(_mm256_xor_si256(row, _mm256_srli_epi64(row, 1)), adj)),
+    _mm256_add_epi8(_mm256_andnot_si256(row, one),
+                    _mm256_srl_epi64(_mm256_andnot_si256(row, top), shift))));
+  s.column_transitions = _mm256_add_epi8(s.column_transitions, popcount256(
+    _mm256_and_si256(_mm256_xor_si256(row, below), full)));
+}
+
+EVAL_TARGET("avx2") void zero256(Vec256& s)
+{
+  s.aggregate_height = s.max_height = s.holes = s.bumpiness = s.wells =
+    s.row_transitions = s.column_transitions = _mm256_setzero_si256();
+}
+
+EVAL_TARGET("avx2") void flush256(Vec256& bytes, Vec256& totals)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  totals.aggregate_height = _mm256_add_epi64(totals.aggregate_height,
+                                             _mm256_sad_epu8(bytes.aggregate_height, zero));
+  totals.max_height = _mm256_add_epi64(totals.max_height,
+                                       _mm256_sad_epu8(bytes.max_height, zero));
+  totals.holes = _mm256_add_epi64(totals.holes, _mm256_sad_epu8(bytes.holes, zero));
+  totals.bumpiness = _mm256_add_epi64(totals.bumpiness,
+                                      _mm256_sad_epu8(bytes.bumpiness, zero));
+  totals.wells = _mm256_add_epi64(totals.wells, _mm256_sad_epu8(bytes.wells, zero));
+  totals.row_transitions = _mm256_add_epi64(totals.row_transitions,
+                                            _mm256_sad_epu8(bytes.row_transitions, zero));
+  totals.column_transitions = _mm256_add_epi64(totals.column_transitions,
+                                               _mm256_sad_epu8(bytes.column_transitions, zero));
+  zero256(bytes);
+}
+
+EVAL_TARGET("avx2") void lanes256(const Vec256& s, Sums* sums)
+{
+  alignas(32) uint64_t v[7][4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[0]), s.aggregate_height);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[1]), s.max_height);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[2]), s.holes);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[3]), s.bumpiness);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[4]), s.wells);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[5]), s.row_transitions);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(v[6]), s.column_transitions);
+  for(int i = 0; i < 4; ++i) {
+    sums[i].aggregate_height = v[0][i];
+    sums[i].max_height = v[1][i];
+    sums[i].holes = v[2][i];
+    sums[i].bumpiness = v[3][i];
+    sums[i].wells = v[4][i];
+    sums[i].row_transitions = v[5][i];
+    sums[i].column_transitions = v[6][i];
+  }
+}
+
+EVAL_TARGET("avx2") void boardAVX2(const uint64_t* rows, int count,
+                                   const Masks& m, BoardEval& out)
+{
+  alignas(32) uint64_t row[BLOCK_ROWS + 3];
+  alignas(32) uint64_t below[BLOCK_ROWS + 3];
+  alignas(32) uint64_t cover[BLOCK_ROWS + 3];
+
+  Vec256 bytes;
+  Vec256 totals;
+  zero256(bytes);
+  zero256(totals);
+  uint64_t cov = 0;
+  int lanes = 0;
+  int steps = 0;
+  for(int hi = count; hi > 0; hi -= BLOCK_ROWS) {
+    int n = fillBlock(rows, std::max(hi - BLOCK_ROWS, 0), hi, m, cov,
+                      row, below, cover);
+    while(n & 3) {
+      row[n] = below[n] = cover[n] = 0;
+      ++n;
+    }
+    for(int i = 0; i < n; i += 4) {
+      accumulate256(_mm256_load_si256(reinterpret_cast<const __m256i*>(row + i)),
+                    _mm256_load_si256(reinterpret_cast<const __m256i*>(below + i)),
+                    _mm256_load_si256(reinterpret_cast<const __m256i*>(cover + i)),
+                    m, bytes);
+      if(++steps == FLUSH_STEPS) {
+        flush256(bytes, totals);
+        steps = 0;
+      }
+    }
+    lanes += n;
+  }
+  flush256(bytes, totals);
+
+  Sums sums[4];
+  lanes256(totals, sums);
+  finish(addLanes(sums, 4), lanes, out);
+}
+
+EVAL_TARGET("avx2") void batchAVX2(const uint64_t* rows, int stride, int boards,
+                                   int count, const Masks& m, BoardEval* out)
+{
+  const __m256i full = _mm256_set1_epi64x(m.full);
+  int b = 0;
+  for(; b + 4 <= boards; b += 4) {
+    const uint64_t* r0 = rows + size_t(b) * stride;
+    const uint64_t* r1 = r0 + stride;
+    const uint64_t* r2 = r1 + stride;
+    const uint64_t* r3 = r2 + stride;
+
+    Vec256 bytes;
+    Vec256 totals;
+    zero256(bytes);
+    zero256(totals);
+    __m256i cov = _mm256_setzero_si256();
+    __m256i row = _mm256_and_si256(
+      _mm256_set_epi64x(r3[count-1], r2[count-1], r1[count-1], r0[count-1]), full);
+    for(int r = count - 1, steps = 0; r >= 0; --r) {
+      __m256i below = r > 0
+        ? _mm256_and_si256(_mm256_set_epi64x(r3[r-1], r2[r-1], r1[r-1], r0[r-1]), full)
+        : full;
+      cov = _mm256_or_si256(cov, row);
+      accumulate256(row, below, cov, m, bytes);
+      if(++steps == FLUSH_STEPS) {
+        flush256(bytes, totals);
+        steps = 0;
+      }
+      row = below;
+    }
+    flush256(bytes, totals);
+
+    Sums sums[4];
+    lanes256(totals, sums);
+    for(int i = 0; i < 4; ++i) {
+      finish(sums[i], count, out[b+i]);
+    }
+  }
+  batchSSE2(rows + size_t(b) * stride, stride, boards - b, count, m, out + b);
+}
+
+#endif // EVAL_X86
+
+// -- dispatch -------------------------------------------------------
+
+typedef void (*BoardKernel)(const uint64_t*, int, const Masks&, BoardEval&);
+typedef void (*BatchKernel)(const uint64_t*, int, int, int, const Masks&,
+                            BoardEval*);
+
+struct Kernel {
+  EvalPath path;
+  BoardKernel board;
+  BatchKernel batch;
+};
+
+Kernel kernelFor(EvalPath path)
+{
+  Kernel k = { EVAL_SCALAR, boardScalar, batchScalar };
+#ifdef EVAL_X86
+  if(path == EVAL_SSE2) {
+    k.path = path;
+    k.board = boardSSE2;
+    k.batch = batchSSE2;
+  } else if(path == EVAL_AVX2) {
+    k.path = path;
+    k.board = boardAVX2;
+    k.batch = batchAVX2;
+  }
+#endif
+  return k;
+}
+
+EvalPath bestPath()
+{
+  if(isEvalPathSupported(EVAL_AVX2)) {
+    return EVAL_AVX2;
+  }
+  if(isEvalPathSupported(EVAL_SSE2)) {
+    return EVAL_SSE2;
+  }
+  return EVAL_SCALAR;
+}
+
+Kernel kernel = kernelFor(bestPath());
+
+} // namespace
+
+bool isEvalPathSupported(EvalPath path)
+{
+  switch(path) {
+  case EVAL_SCALAR:
+    return true;
+#ifdef EVAL_X86
+  case EVAL_SSE2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+  case EVAL_AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+const char* getEvalPathName(EvalPath path)
+{
+  switch(path) {
+  case EVAL_SSE2: return "sse2";
+  case EVAL_AVX2: return "avx2";
+  default: return "scalar";
+  }
+}
+
+EvalPath getEvalPath()
+{
+  return kernel.path;
+}
+
+bool setEvalPath(EvalPath path)
+{
+  if(!isEvalPathSupported(path)) {
+    return false;
+  }
+  kernel = kernelFor(path);
+  return true;
+}
+
+void evaluateBoard(const uint64_t* rows, int count, int width, BoardEval& out)
+{
+  kernel.board(rows, count, makeMasks(width), out);
+}
+
+void evaluateBoards(const uint64_t* rows, int stride, int boards, int count,
+                    int width, BoardEval* out)
+{
+  kernel.batch(rows, stride, boards, count, makeMasks(width), out);
+}
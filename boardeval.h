@@ -0,0 +1,63 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Board evaluation kernel - the features autoplayer heuristics weigh,
+ * computed from row bitmasks, for one board or a batch of them.  There
+ * are AVX2, SSE2 and scalar versions, and the fastest one the CPU runs
+ * is picked when the program starts.
+ *
+ * Every feature is a sum over rows of bit counts, using the row, the
+ * row below it and the row's "cover": the OR of the row and every row
+ * above it, which has bit c set exactly where column c's height
+ * reaches the row.  Boards of a batch, or the rows of one board, then
+ * fill the lanes of a vector.
+ */
+
+#ifndef BOARDEVAL_H
+#define BOARDEVAL_H
+
+#include <cstdint>
+
+struct BoardEval {
+  // Sum and maximum of the column heights.
+  int aggregate_height;
+  int max_height;
+  // Empty cells under the top of their column.
+  int holes;
+  // Sum of the height differences between neighbouring columns.
+  int bumpiness;
+  // Sum over columns lower than both neighbours (a wall counts as
+  // infinitely high) of how much lower.
+  int wells;
+  // Filled/empty changes along each row up to the highest column,
+  // the walls counting as filled.
+  int row_transitions;
+  // Filled/empty changes up each column between the given rows, the
+  // floor counting as filled.
+  int column_transitions;
+};
+
+enum EvalPath {EVAL_SCALAR, EVAL_SSE2, EVAL_AVX2};
+
+// The path in use.  The best one the CPU supports unless set.
+EvalPath getEvalPath();
+
+// Switch to the given path, for comparing them.  Returns false, and
+// changes nothing, if the CPU cannot run it.
+bool setEvalPath(EvalPath path);
+
+bool isEvalPathSupported(EvalPath path);
+const char* getEvalPathName(EvalPath path);
+
+// Features of a board width columns wide, at most 64, whose rows from
+// the bottom up are the count words at rows, bit c of each set when
+// column c is filled.
+void evaluateBoard(const uint64_t* rows, int count, int width, BoardEval& out);
+
+// The same for boards boards, board i's rows starting at
+// rows + i*stride, each count rows of width columns.
+void evaluateBoards(const uint64_t* rows, int stride, int boards, int count,
+                    int width, BoardEval* out);
+
+#endif // BOARDEVAL_H
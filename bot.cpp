@@ -0,0 +1,160 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Bot - a beam search autoplayer.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "bot.h"
+#include "heuristic.h"
+#include "transtable.h"
+#include "workpool.h"
+
+namespace {
+
+// The score of a placement that ends the game.
+const double GAME_OVER = -std::numeric_limits<double>::infinity();
+
+} // namespace
+
+Bot::Bot(const Heuristic& heuristic, int beam_width, int lookahead,
+         WorkPool* pool)
+  : heuristic_(heuristic)
+  , beam_width_(std::max(beam_width, 1))
+  , lookahead_(std::max(lookahead, 0))
+  , pool_(pool)
+  , table_(nullptr)
+  , scored_(0)
+{
+}
+
+bool Bot::choose(const Game& game, Placement& best)
+{
+  int workers = pool_ ? pool_->size() : 1;
+  if(int(scratch_.size()) != workers ||
+     scratch_[0].getWidth() != game.getWidth() ||
+     scratch_[0].getHeight() != game.getHeight()) {
+    scratch_.assign(workers, game);
+  }
+  scratch_node_.assign(workers, -1);
+
+  beam_.clear();
+  beam_.push_back(Node(game));
+  beam_[0].game.setJournaling(false);
+  beam_[0].game.clearJournal();
+
+  // Only the previewed pieces are known; anything deeper would be
+  // peeking at the piece source's future.
+  int depth = 1 + std::min(lookahead_, game.getPieceSource().getLookahead());
+  bool found = false;
+
+  for(int level = 0; level < depth; ++level) {
+    placements_.resize(beam_.size());
+    candidates_.clear();
+    for(size_t n = 0; n < beam_.size(); ++n) {
+      beam_[n].game.enumeratePlacements(placements_[n]);
+      for(size_t i = 0; i < placements_[n].size(); ++i) {
+        Candidate c = { int(n), placements_[n][i], 0, 0 };
+        candidates_.push_back(c);
+      }
+    }
+    if(candidates_.empty()) {
+      break;
+    }
+
+    // Candidates of one node sit side by side, so each worker mostly
+    // keeps playing from the same scratch copy.
+    std::fill(scratch_node_.begin(), scratch_node_.end(), -1);
+    if(pool_) {
+      pool_->run(long(candidates_.size()), [this](long i, int worker) {
+        scoreCandidate(i, worker);
+      });
+    } else {
+      for(size_t i = 0; i < candidates_.size(); ++i) {
+        scoreCandidate(long(i), 0);
+      }
+    }
+    scored_ += long(candidates_.size());
+
+    order_.resize(candidates_.size());
+    for(size_t i = 0; i < order_.size(); ++i) {
+      order_[i] = long(i);
+    }
+    size_t keep = std::min(order_.size(), size_t(beam_width_));
+    std::partial_sort(order_.begin(), order_.begin() + keep, order_.end(),
+                      [this](long a, long b) {
+      return candidates_[a].score > candidates_[b].score;
+    });
+
+    next_.clear();
+    for(size_t k = 0; k < keep; ++k) {
+      const Candidate& c = candidates_[ order_[k] ];
+      const Node& parent = beam_[c.node];
+      next_.push_back(Node(parent.game));
+      Node& child = next_.back();
+      child.game.play(c.placement);
+      child.lines = c.lines;
+      child.score = c.score;
+      child.first = level == 0 ? c.placement : parent.first;
+    }
+    beam_.swap(next_);
+    found = true;
+  }
+
+  if(!found) {
+    return false;
+  }
+
+  size_t top = 0;
+  for(size_t n = 1; n < beam_.size(); ++n) {
+    if(beam_[n].score > beam_[top].score) {
+      top = n;
+    }
+  }
+  best = beam_[top].first;
+  return true;
+}
+
+int Bot::play(Game& game)
+{
+  Placement best;
+  if(!choose(game, best)) {
+    return -1;
+  }
+  return game.play(best);
+}
+
+// Play candidate i on the worker's scratch copy of its node, score the
+// result and take it back.
+void Bot::scoreCandidate(long i, int worker)
+{
+  Candidate& c = candidates_[i];
+  const Node& parent = beam_[c.node];
+  Game& scratch = scratch_[worker];
+
+  if(scratch_node_[worker] != c.node) {
+    scratch = parent.game;
+    scratch.setJournaling(true);
+    scratch_node_[worker] = c.node;
+  }
+
+  int rm = scratch.play(c.placement);
+  if(rm < 0) {
+    c.lines = parent.lines;
+    c.score = GAME_OVER;
+  } else {
+    c.lines = parent.lines + rm;
+    // The score depends on the lines cleared as well as the board.
+    uint64_t key = scratch.getHash() ^ (uint64_t(c.lines) * 0x9e3779b97f4a7c15ULL);
+    if(!table_ || !table_->probe(key, c.score)) {
+      c.score = heuristic_.evaluate(scratch, c.lines);
+      if(table_) {
+        table_->store(key, c.score);
+      }
+    }
+  }
+  scratch.undo();
+}
@@ -0,0 +1,110 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Bot - an autoplayer.  Each move is a beam search over where the
+ * falling piece and the previewed pieces after it can be placed, with
+ * the candidates at every level scored by a Heuristic across the
+ * threads of a WorkPool.
+ */
+
+#ifndef BOT_H
+#define BOT_H
+
+#include <vector>
+
+#include "game.h"
+
+class Heuristic;
+class TranspositionTable;
+class WorkPool;
+
+class Bot
+{
+public:
+  // Keep the beam_width best states at each level of the search and
+  // look lookahead pieces past the falling one, or as many as the
+  // game's piece source previews if that is fewer.  Candidates are
+  // scored on pool's threads, or on the caller's if pool is null.
+  // The heuristic and pool must outlive the bot.
+  Bot(const Heuristic& heuristic, int beam_width = 16, int lookahead = 1,
+      WorkPool* pool = nullptr);
+
+  // Search for the best place for game's falling piece.  Returns
+  // false if there is nowhere to put it.
+  bool choose(const Game& game, Placement& best);
+
+  // Choose and play the best placement.  Returns what Game::play
+  // returns, or -1 if there was nowhere to put the piece.
+  int play(Game& game);
+
+  int getBeamWidth() const
+  {
+    return beam_width_;
+  }
+  int getLookahead() const
+  {
+    return lookahead_;
+  }
+
+  // Look scores up in table before asking the heuristic, and keep new
+  // ones there.  Bots sharing a table must share a heuristic.  Null,
+  // the default, turns the table off.
+  void setTranspositionTable(TranspositionTable* table)
+  {
+    table_ = table;
+  }
+
+  // Placements scored since the bot was made.
+  long getPlacementsScored() const
+  {
+    return scored_;
+  }
+
+private:
+  // A state kept in the beam: the game after some placements, the
+  // rows they cleared, its score and the first placement on the way.
+  struct Node {
+    explicit Node(const Game& game)
+      : game(game)
+      , lines(0)
+      , score(0)
+    {}
+
+    Game game;
+    int lines;
+    double score;
+    Placement first;
+  };
+
+  // One placement of one node's piece, with the outcome of playing it.
+  struct Candidate {
+    int node;
+    Placement placement;
+    int lines;
+    double score;
+  };
+
+  void scoreCandidate(long i, int worker);
+
+  const Heuristic& heuristic_;
+  int beam_width_;
+  int lookahead_;
+  WorkPool* pool_;
+  TranspositionTable* table_;
+
+  long scored_;
+
+  std::vector<Node> beam_;
+  std::vector<Node> next_;
+  std::vector<std::vector<Placement> > placements_;
+  std::vector<Candidate> candidates_;
+  std::vector<long> order_;
+
+  // Per worker: a scratch copy of the node it last scored candidates
+  // for, played forward and undone for each one.
+  std::vector<Game> scratch_;
+  std::vector<int> scratch_node_;
+};
+
+#endif // BOT_H
@@ -0,0 +1,9 @@
+# tetris-bot: the beam search autoplayer, headless.
+TEMPLATE = app
+TARGET = tetris-bot
+CONFIG += console release
+CONFIG -= qt app_bundle
+
+include(../engine/engine.pri)
+
+SOURCES += main.cpp
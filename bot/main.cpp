@@ -0,0 +1,213 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * tetris-bot - lets the beam search autoplayer play one game without
+ * a GUI and reports how well and how fast it played.  With -S it
+ * plays the same stretch of game again on 1, 2, 4, ... threads up to
+ * the -t count, keeping the best of a few runs at each, and reports
+ * how the search scales.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "bot.h"
+#include "game.h"
+#include "heuristic.h"
+#include "transtable.h"
+#include "workpool.h"
+
+namespace {
+
+// Runs at each thread count under -S, of which the fastest is kept.
+const int SCALING_RUNS = 3;
+
+struct Options {
+  int width;
+  int height;
+  int threads;
+  int beam;
+  int lookahead;
+  long pieces;
+  int table_bits;
+  uint64_t seed;
+  PieceSource::Mode mode;
+  bool scaling;
+};
+
+struct Result {
+  long pieces;
+  long lines;
+  long scored;
+  double hit_rate;
+  double elapsed;
+  bool over;
+};
+
+void usage()
+{
+  std::fprintf(stderr,
+               "usage: tetris-bot [-n max-pieces] [-w width] [-h height] [-t threads]\n"
+               "                  [-b beam-width] [-l lookahead] [-s seed]\n"
+               "                  [-p uniform|bag] [-T log2-table-size] [-S]\n");
+}
+
+bool parseOptions(int argc, char *argv[], Options& opts)
+{
+  opts.width = 10;
+  opts.height = 20;
+  opts.threads = 0;
+  opts.beam = 16;
+  opts.lookahead = 1;
+  opts.pieces = 1000;
+  opts.table_bits = 0;
+  opts.seed = 1;
+  opts.mode = PieceSource::BAG;
+  opts.scaling = false;
+
+  for(int i = 1; i < argc; ++i) {
+    if(std::strcmp(argv[i], "-S") == 0) {
+      opts.scaling = true;
+      continue;
+    }
+    if(i + 1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2) {
+      return false;
+    }
+    if(argv[i][1] == 'p') {
+      const char *mode = argv[++i];
+      if(std::strcmp(mode, "uniform") == 0) {
+        opts.mode = PieceSource::UNIFORM;
+      } else if(std::strcmp(mode, "bag") != 0) {
+        return false;
+      }
+      continue;
+    }
+
+    long value = std::atol(argv[++i]);
+    switch(argv[i-1][1]) {
+      case 'n': opts.pieces = value; break;
+      case 'w': opts.width = int(value); break;
+      case 'h': opts.height = int(value); break;
+      case 't': opts.threads = int(value); break;
+      case 'b': opts.beam = int(value); break;
+      case 'l': opts.lookahead = int(value); break;
+      case 'T': opts.table_bits = int(value); break;
+      case 's': opts.seed = std::strtoull(argv[i], nullptr, 10); break;
+      default: return false;
+    }
+  }
+
+  return opts.pieces > 0 && opts.width >= 4 && opts.height >= 1 &&
+         opts.beam >= 1 && opts.lookahead >= 0 &&
+         opts.table_bits >= 0 && opts.table_bits <= 32;
+}
+
+// Let the bot play a game on the given number of threads until it
+// ends or max pieces have been placed.
+Result playGame(const Options& opts, int threads)
+{
+  // The source previews as many pieces as the bot looks ahead.
+  int preview = opts.lookahead > 0 ? opts.lookahead : 1;
+  Game game(opts.width, opts.height, PieceSource(opts.seed, opts.mode, preview));
+  WeightedHeuristic heuristic;
+  WorkPool pool(threads);
+  Bot bot(heuristic, opts.beam, opts.lookahead, &pool);
+
+  // Scores for boards the search has already seen, if asked for.
+  TranspositionTable* table = nullptr;
+  if(opts.table_bits > 0) {
+    table = new TranspositionTable(opts.table_bits);
+    bot.setTranspositionTable(table);
+  }
+
+  Result result = Result();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while(result.pieces < opts.pieces) {
+    int rm = bot.play(game);
+    if(rm < 0) {
+      result.over = true;
+      break;
+    }
+    ++result.pieces;
+    result.lines += rm;
+  }
+  result.elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  result.scored = bot.getPlacementsScored();
+  result.hit_rate = table ? table->getHitRate() : 0.0;
+  delete table;
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Options opts;
+  if(!parseOptions(argc, argv, opts)) {
+    usage();
+    return 2;
+  }
+
+  int threads = opts.threads > 0 ? opts.threads
+                                 : int(std::thread::hardware_concurrency());
+  if(threads < 1) {
+    threads = 1;
+  }
+
+  std::printf("well          %dx%d\n", opts.width, opts.height);
+  std::printf("seed          %llu (%s)\n", (unsigned long long)opts.seed,
+              opts.mode == PieceSource::BAG ? "bag" : "uniform");
+  std::printf("beam          %d wide, %d piece lookahead\n",
+              opts.beam, opts.lookahead);
+
+  if(!opts.scaling) {
+    Result r = playGame(opts, threads);
+    std::printf("threads       %d\n", threads);
+    std::printf("pieces        %ld%s\n", r.pieces, r.over ? " (game over)" : "");
+    std::printf("lines         %ld\n", r.lines);
+    std::printf("elapsed       %.3f s\n", r.elapsed);
+    std::printf("pieces/sec    %.1f\n", r.pieces / r.elapsed);
+    std::printf("placements/s  %.0f scored\n", r.scored / r.elapsed);
+    if(opts.table_bits > 0) {
+      std::printf("table         2^%d entries, %.1f%% hits\n",
+                  opts.table_bits, 100.0 * r.hit_rate);
+    }
+    return 0;
+  }
+
+  // Every run plays the same game, so the work is identical and only
+  // the thread count changes.  A first run, not reported, takes the
+  // cold start (page faults, the allocator growing its arenas, the
+  // pool's threads first being created), and each count then keeps
+  // the best of SCALING_RUNS runs, so the 1-thread baseline does not
+  // pay for either.
+  playGame(opts, threads);
+  std::printf("%7s %14s %12s %9s %11s\n",
+              "threads", "placements/s", "pieces/s", "speedup", "efficiency");
+  double base = 0;
+  for(int t = 1; ; t = t * 2 < threads ? t * 2 : threads) {
+    Result r = playGame(opts, t);
+    for(int run = 1; run < SCALING_RUNS; ++run) {
+      Result again = playGame(opts, t);
+      if(again.elapsed < r.elapsed) {
+        r = again;
+      }
+    }
+    double rate = r.scored / r.elapsed;
+    if(t == 1) {
+      base = rate;
+    }
+    std::printf("%7d %14.0f %12.1f %8.2fx %10.0f%%\n", t, rate,
+                r.pieces / r.elapsed, rate / base, 100.0 * rate / base / t);
+    if(t == threads) {
+      break;
+    }
+  }
+
+  return 0;
+}
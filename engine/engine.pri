@@ -0,0 +1,5 @@
+# Included by every project that links against libtetris.
+CONFIG += c++14 thread
+INCLUDEPATH += $$PWD/..
+LIBS += -L$$OUT_PWD/../engine -ltetris
+PRE_TARGETDEPS += $$OUT_PWD/../engine/libtetris.a
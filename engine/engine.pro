@@ -0,0 +1,16 @@
+# libtetris: the game engine as a static library, no Qt modules.
+TEMPLATE = lib
+TARGET = tetris
+CONFIG += staticlib c++14 thread
+CONFIG -= qt
+
+INCLUDEPATH += ..
+
+HEADERS += ../arena.h ../basicgame.h ../batch.h ../boardeval.h ../bot.h \
+           ../game.h ../heuristic.h ../inputlog.h ../occupancy.h \
+           ../piecesource.h ../recordfile.h ../timeline.h ../transtable.h \
+           ../workpool.h
+SOURCES += ../arena.cpp ../batch.cpp ../boardeval.cpp ../bot.cpp \
+           ../game.cpp ../heuristic.cpp ../inputlog.cpp ../piecesource.cpp \
+           ../recordfile.cpp ../timeline.cpp ../transtable.cpp \
+           ../workpool.cpp
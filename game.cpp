@@ -10,275 +10,771 @@
  */
 
 #include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "game.h"
+#include "arena.h"
+#include "occupancy.h"
+#include "workpool.h"
 
-static const Piece PIECES[] = {
-  Piece(
+namespace {
+
+constexpr uint16_t maskFromDesc(const char *desc)
+{
+  uint16_t mask = 0;
+  for(int i = 0; i < 16; ++i) {
+    if(desc[i] == 'x') {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+}
+
+// New row r is old column r read from the bottom up, and the margins
+// turn with the cells.
+constexpr PieceShape rotatedCW(const PieceShape& s)
+{
+  PieceShape n = { 0, { s.margins[3], s.margins[0], s.margins[1], s.margins[2] }, {}, {} };
+  for(int r = 0; r < 4; ++r) {
+    for(int c = 0; c < 4; ++c) {
+      if((s.mask >> ((3-c)*4 + r)) & 1) {
+        n.mask |= 1 << (r*4 + c);
+      }
+    }
+  }
+  return n;
+}
+
+constexpr PieceShape fromDesc(const char *desc,
+                              int left, int top, int right, int bottom)
+{
+  return PieceShape{ maskFromDesc(desc),
+                     { int8_t(left), int8_t(top), int8_t(right), int8_t(bottom) },
+                     {}, {} };
+}
+
+constexpr PieceShape withProfile(PieceShape s)
+{
+  for(int c = 0; c < 4; ++c) {
+    s.top[c] = -1;
+    s.bottom[c] = -1;
+    for(int r = 0; r < 4; ++r) {
+      if((s.mask >> (r*4 + c)) & 1) {
+        if(s.top[c] < 0) {
+          s.top[c] = r;
+        }
+        s.bottom[c] = r;
+      }
+    }
+  }
+  return s;
+}
+
+constexpr PieceShape BASE_SHAPES[7] = {
+  fromDesc(
         ".x.."
         ".x.."
         ".x.."
-        ".x..", 0,			1,0,2,0),
-  Piece(
+        ".x..",			1,0,2,0),
+  fromDesc(
         "...."
         ".xx."
         ".x.."
-        ".x..", 1,			1,1,1,0),
-  Piece(
+        ".x..",			1,1,1,0),
+  fromDesc(
         "...."
         ".xx."
         "..x."
-        "..x.", 2,			1,1,1,0),
-  Piece(
+        "..x.",			1,1,1,0),
+  fromDesc(
         "...."
         ".x.."
         ".xx."
-        "..x.", 3,			1,1,1,0),
-  Piece(
+        "..x.",			1,1,1,0),
+  fromDesc(
         "...."
         "..x."
         ".xx."
-        ".x..", 4,			1,1,1,0),
-  Piece(
+        ".x..",			1,1,1,0),
+  fromDesc(
         "...."
         "xxx."
         ".x.."
-        "....", 5,			0,1,1,1),
-  Piece(
+        "....",			0,1,1,1),
+  fromDesc(
         "...."
         ".xx."
         ".xx."
-        "....", 6,			1,1,1,1)
+        "....",			1,1,1,1)
 };
 
-Piece::Piece(const char *desc, int cindex, 
-              int left, int top, int right, int bottom)
+constexpr PieceShape turned(int kind, int turns)
 {
-  std::copy(desc, desc + 16, desc_);
-  cindex_ = cindex;
-  margins_[0] = left;
-  margins_[1] = top;
-  margins_[2] = right;
-  margins_[3] = bottom;
+  PieceShape s = BASE_SHAPES[kind];
+  for(int i = 0; i < turns; ++i) {
+    s = rotatedCW(s);
+  }
+  return withProfile(s);
 }
 
-Piece::Piece()
-{}
+#define ORIENTATIONS(k) { turned(k, 0), turned(k, 1), turned(k, 2), turned(k, 3) }
+
+} // namespace
 
-Piece& Piece::operator =(const Piece& other)
+constexpr PieceShape PIECE_SHAPES[7][4] = {
+  ORIENTATIONS(0), ORIENTATIONS(1), ORIENTATIONS(2), ORIENTATIONS(3),
+  ORIENTATIONS(4), ORIENTATIONS(5), ORIENTATIONS(6)
+};
+
+#undef ORIENTATIONS
+
+namespace {
+
+constexpr bool fullTurnIsIdentity()
 {
-  std::copy(other.desc_, other.desc_ + 16, desc_);
-  std::copy(other.margins_, other.margins_ + 4, margins_);
-  cindex_ = other.cindex_;
-  return *this;
+  for(int k = 0; k < 7; ++k) {
+    PieceShape s = rotatedCW(PIECE_SHAPES[k][3]);
+    if(s.mask != PIECE_SHAPES[k][0].mask) {
+      return false;
+    }
+    for(int m = 0; m < 4; ++m) {
+      if(s.margins[m] != PIECE_SHAPES[k][0].margins[m]) {
+        return false;
+      }
+    }
+  }
+  return true;
 }
 
-int Piece::getLeftMargin() const
+static_assert(fullTurnIsIdentity(), "four clockwise turns must restore every piece");
+static_assert(PIECE_SHAPES[0][1].mask == 0x00f0, "a turned bar lies along row 1");
+static_assert(PIECE_SHAPES[5][0].bottom[1] == 2, "the T points down");
+
+} // namespace
+
+namespace {
+
+// Stands in for every chunk of a snapshot that holds no cells at all,
+// so empty rows above the stack cost nothing to save.
+const char EMPTY_CHUNK = 0;
+
+// The board hash is Zobrist hashing with the keys computed instead of
+// tabled: each word of a row gets a key from its contents and place in
+// the row, each row one from the XOR of its word keys and its height
+// in the well, and the board hash is the XOR of the row keys.  Empty
+// words and rows key to zero, so they never need visiting, and moving
+// a row only costs rekeying it rather than every cell in it.
+inline uint64_t mixBits(uint64_t z)
 {
-  return margins_[0];
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
 }
 
-int Piece::getTopMargin() const
+inline uint64_t wordKey(RowWord word, int w)
 {
-  return margins_[1];
+  return word ? mixBits(word + uint64_t(w) * 0x9e3779b97f4a7c15ULL) : 0;
 }
 
-int Piece::getRightMargin() const
+inline uint64_t rowKey(uint64_t row_hash, int r)
 {
-  return margins_[2];
+  return row_hash ? mixBits(row_hash ^ (uint64_t(r) * 0xd1b54a32d192ed03ULL + 1)) : 0;
 }
 
-int Piece::getBottomMargin() const
+// Journal record tags.
+enum {
+  JOURNAL_STEP,   // start of a call's records
+  JOURNAL_MOVE,   // piece, x, y: the falling piece before it moved
+  JOURNAL_LOCK,   // 4 heights: the columns under a piece before it locked
+  JOURNAL_STOP,   // the game ended
+  JOURNAL_SPAWN,  // source, piece, x, y: before a new piece spawned
+  JOURNAL_ROWS,   // (row, colours)..., heights, count: rows removed
+  JOURNAL_CELL    // row, column, colour, height: a cell before set()
+};
+
+} // namespace
+
+Game::Game(int width, int height, const PieceSource& pieces,
+           CellStorage storage)
+  : board_width_(width)
+  , board_height_(height)
+  , stopped_(false)
+  , pieces_(pieces)
 {
-  return margins_[3];
+  size_t sz = size_t(board_width_) * (board_height_+4);
+
+  words_per_row_ = (board_width_ + 63) / 64;
+  rows_ = new RowWord[ size_t(words_per_row_) * (board_height_+4) ];
+  std::fill(rows_, rows_ + size_t(words_per_row_) * (board_height_+4), 0);
+
+  board_ = nullptr;
+  packed_ = nullptr;
+  if(storage == CELLS_PACKED) {
+    size_t bytes = packedRowBytes() * (board_height_+4);
+    packed_ = new unsigned char[ bytes ];
+    std::fill(packed_, packed_ + bytes, 0);
+  } else {
+    board_ = new int[ sz ];
+    std::fill(board_, board_ + sz, -1);
+  }
+
+  slot_ = new int[ board_height_+4 ];
+  for(int r = 0; r < board_height_+4; ++r) {
+    slot_[r] = r;
+  }
+
+  row_fill_ = new int[ board_height_+4 ];
+  std::fill(row_fill_, row_fill_ + board_height_+4, 0);
+  full_rows_ = 0;
+  lowest_full_row_ = board_height_ + 4;
+
+  heights_ = new int[ board_width_ ];
+  std::fill(heights_, heights_ + board_width_, 0);
+
+  row_hash_ = new uint64_t[ board_height_+4 ];
+  std::fill(row_hash_, row_hash_ + board_height_+4, 0);
+  hash_ = 0;
+
+  clean_ = new const char*[ numChunks() ];
+  forgetChunks(nullptr, 0);
+
+  journaling_ = false;
+  step_open_ = false;
+  pool_ = nullptr;
+
+  generateNewPiece();
 }
 
-int Piece::getColourIndex() const
+Game::Game(const Game& other)
+  : board_width_(other.board_width_)
+  , board_height_(other.board_height_)
+  , stopped_(other.stopped_)
+  , pieces_(other.pieces_)
+  , piece_(other.piece_)
+  , px_(other.px_)
+  , py_(other.py_)
+  , words_per_row_(other.words_per_row_)
+  , full_rows_(other.full_rows_)
+  , lowest_full_row_(other.lowest_full_row_)
+  , hash_(other.hash_)
+  , clean_arena_(other.clean_arena_)
+  , clean_generation_(other.clean_generation_)
+  , journaling_(other.journaling_)
+  , step_open_(other.step_open_)
+  , journal_(other.journal_)
+  , pool_(other.pool_)
 {
-  return cindex_;
+  int rows = board_height_ + 4;
+
+  rows_ = new RowWord[ size_t(words_per_row_) * rows ];
+  std::copy(other.rows_, other.rows_ + size_t(words_per_row_) * rows, rows_);
+
+  board_ = nullptr;
+  packed_ = nullptr;
+  if(other.packed_) {
+    size_t bytes = packedRowBytes() * rows;
+    packed_ = new unsigned char[ bytes ];
+    std::copy(other.packed_, other.packed_ + bytes, packed_);
+  } else {
+    board_ = new int[ size_t(board_width_) * rows ];
+    std::copy(other.board_, other.board_ + size_t(board_width_) * rows, board_);
+  }
+
+  slot_ = new int[ rows ];
+  std::copy(other.slot_, other.slot_ + rows, slot_);
+
+  row_fill_ = new int[ rows ];
+  std::copy(other.row_fill_, other.row_fill_ + rows, row_fill_);
+
+  heights_ = new int[ board_width_ ];
+  std::copy(other.heights_, other.heights_ + board_width_, heights_);
+
+  row_hash_ = new uint64_t[ rows ];
+  std::copy(other.row_hash_, other.row_hash_ + rows, row_hash_);
+
+  // The copy holds the same rows, so it can share the same chunks.
+  clean_ = new const char*[ numChunks() ];
+  std::copy(other.clean_, other.clean_ + numChunks(), clean_);
 }
 
-Piece Piece::rotateCW() const
+Game::Game(Game&& other) noexcept
+  : board_width_(other.board_width_)
+  , board_height_(other.board_height_)
+  , stopped_(other.stopped_)
+  , pieces_(other.pieces_)
+  , piece_(other.piece_)
+  , px_(other.px_)
+  , py_(other.py_)
+  , words_per_row_(other.words_per_row_)
+  , rows_(other.rows_)
+  , board_(other.board_)
+  , packed_(other.packed_)
+  , slot_(other.slot_)
+  , row_fill_(other.row_fill_)
+  , full_rows_(other.full_rows_)
+  , lowest_full_row_(other.lowest_full_row_)
+  , heights_(other.heights_)
+  , row_hash_(other.row_hash_)
+  , hash_(other.hash_)
+  , clean_(other.clean_)
+  , clean_arena_(other.clean_arena_)
+  , clean_generation_(other.clean_generation_)
+  , journaling_(other.journaling_)
+  , step_open_(other.step_open_)
+  , journal_(std::move(other.journal_))
+  , pool_(other.pool_)
 {
-  char ndesc[16];
-  getColumnRev(0, (char*)ndesc);
-  getColumnRev(1, (char*)(ndesc+4));
-  getColumnRev(2, (char*)(ndesc+8));
-  getColumnRev(3, (char*)(ndesc+12));
-
-  return Piece(ndesc, cindex_,
-		margins_[3], margins_[0], margins_[1], margins_[2]);
+  other.rows_ = nullptr;
+  other.board_ = nullptr;
+  other.packed_ = nullptr;
+  other.slot_ = nullptr;
+  other.row_fill_ = nullptr;
+  other.heights_ = nullptr;
+  other.row_hash_ = nullptr;
+  other.clean_ = nullptr;
 }
 
-Piece Piece::rotateCCW() const
+Game& Game::operator =(Game other)
 {
-  char ndesc[16];
-  getColumn(3, (char*)ndesc);
-  getColumn(2, (char*)(ndesc+4));
-  getColumn(1, (char*)(ndesc+8));
-  getColumn(0, (char*)(ndesc+12));
+  swap(other);
+  return *this;
+}
 
-  return Piece(ndesc, cindex_,
-		margins_[1], margins_[2], margins_[3], margins_[0]);
+void Game::swap(Game& other) noexcept
+{
+  std::swap(board_width_, other.board_width_);
+  std::swap(board_height_, other.board_height_);
+  std::swap(stopped_, other.stopped_);
+  std::swap(pieces_, other.pieces_);
+  std::swap(piece_, other.piece_);
+  std::swap(px_, other.px_);
+  std::swap(py_, other.py_);
+  std::swap(words_per_row_, other.words_per_row_);
+  std::swap(rows_, other.rows_);
+  std::swap(board_, other.board_);
+  std::swap(packed_, other.packed_);
+  std::swap(slot_, other.slot_);
+  std::swap(row_fill_, other.row_fill_);
+  std::swap(full_rows_, other.full_rows_);
+  std::swap(lowest_full_row_, other.lowest_full_row_);
+  std::swap(heights_, other.heights_);
+  std::swap(row_hash_, other.row_hash_);
+  std::swap(hash_, other.hash_);
+  std::swap(clean_, other.clean_);
+  std::swap(clean_arena_, other.clean_arena_);
+  std::swap(clean_generation_, other.clean_generation_);
+  std::swap(journaling_, other.journaling_);
+  std::swap(step_open_, other.step_open_);
+  journal_.swap(other.journal_);
+  std::swap(pool_, other.pool_);
 }
 
-bool Piece::isOn(int row, int col) const
+void Game::reset()
 {
-  return desc_[ row*4 + col ] == 'x';
+  stopped_ = false;
+  std::fill(rows_, rows_ + size_t(words_per_row_) * (board_height_+4), 0);
+  if(packed_) {
+    std::fill(packed_, packed_ + packedRowBytes() * (board_height_+4), 0);
+  } else {
+    std::fill(board_, board_ + size_t(board_width_) * (board_height_+4), -1);
+  }
+  std::fill(row_fill_, row_fill_ + board_height_+4, 0);
+  full_rows_ = 0;
+  lowest_full_row_ = board_height_ + 4;
+  std::fill(heights_, heights_ + board_width_, 0);
+  std::fill(row_hash_, row_hash_ + board_height_+4, 0);
+  hash_ = 0;
+  touchRows(0, board_height_ + 4);
+  generateNewPiece();
+  clearJournal();
 }
 
-void Piece::getColumn(int col, char *buf) const
+void Game::reset(uint64_t seed)
 {
-  buf[0] = desc_[col];
-  buf[1] = desc_[col+4];
-  buf[2] = desc_[col+8];
-  buf[3] = desc_[col+12];
+  pieces_.reseed(seed);
+  reset();
 }
 
-void Piece::getColumnRev(int col, char *buf) const
+Game::~Game()
 {
-  buf[0] = desc_[col+12];
-  buf[1] = desc_[col+8];
-  buf[2] = desc_[col+4];
-  buf[3] = desc_[col];
+  delete [] rows_;
+  delete [] board_;
+  delete [] packed_;
+  delete [] slot_;
+  delete [] row_fill_;
+  delete [] heights_;
+  delete [] row_hash_;
+  delete [] clean_;
 }
 
-Game::Game(int width, int height)
-  : board_width_(width)
-  , board_height_(height)
-  , stopped_(false)
+size_t Game::getMemoryUsage() const
 {
-  int sz = board_width_ * (board_height_+4);
+  int rows = board_height_ + 4;
+  size_t bytes = sizeof(Game);
+  bytes += size_t(words_per_row_) * rows * sizeof(RowWord);
+  if(packed_) {
+    bytes += packedRowBytes() * rows;
+  } else {
+    bytes += size_t(board_width_) * rows * sizeof(int);
+  }
+  bytes += size_t(rows) * (sizeof(int) + sizeof(int) + sizeof(uint64_t));
+  bytes += size_t(board_width_) * sizeof(int);
+  bytes += numChunks() * sizeof(const char*);
+  bytes += journal_.capacity();
+  return bytes;
+}
 
-  board_ = new int[ sz ];
-  std::fill(board_, board_ + sz, -1);
-  generateNewPiece();
+// The colour plane, whichever way it is stored.  See packed_.
+inline int Game::cellAt(int r, int c) const
+{
+  if(packed_) {
+    return ((rowPacked(r)[c >> 1] >> ((c & 1) * 4)) & 0xf) - 1;
+  }
+  return rowCells(r)[c];
 }
 
-void Game::reset()
+inline void Game::putCell(int r, int c, int value)
 {
-  stopped_ = false;
-  std::fill(board_, board_ + (board_width_*(board_height_+4)), -1);
-  generateNewPiece();
+  if(packed_) {
+    unsigned char& b = rowPacked(r)[c >> 1];
+    int shift = (c & 1) * 4;
+    b = (b & ~(0xf << shift)) | ((value + 1) << shift);
+    return;
+  }
+  rowCells(r)[c] = value;
 }
 
-Game::~Game()
+// Empty columns [c0,c1) of row r.  c0 must be even.
+inline void Game::clearCells(int r, int c0, int c1)
 {
-  delete [] board_;
+  if(packed_) {
+    std::fill(rowPacked(r) + c0 / 2, rowPacked(r) + (c1 + 1) / 2, 0);
+    return;
+  }
+  std::fill(rowCells(r) + c0, rowCells(r) + c1, -1);
 }
 
 int Game::get(int r, int c) const
 {
-  return board_[ r*board_width_ + c ];
+  return cellAt(r, c);
 }
 
-int& Game::get(int r, int c) 
+void Game::set(int r, int c, int value)
 {
-  return board_[ r*board_width_ + c ];
+  int cell = cellAt(r, c);
+
+  beginStep();
+  if(journaling_) {
+    beginRecord();
+    put<int32_t>(r);
+    put<int32_t>(c);
+    put<int8_t>(cell);
+    put<int32_t>(heights_[c]);
+    journal_.push_back(JOURNAL_CELL);
+  }
+
+  if((cell == -1) != (value == -1)) {
+    addToRow(r, value == -1 ? -1 : 1);
+  }
+  putCell(r, c, value);
+  touchRows(r, r + 1);
+
+  RowWord bit = RowWord(1) << (c & 63);
+  RowWord& word = rowWords(r)[c >> 6];
+  rekeyWord(r, c >> 6, word, value == -1 ? word & ~bit : word | bit);
+  if(value == -1) {
+    word &= ~bit;
+    if(r + 1 == heights_[c]) {
+      lowerHeight(c, r);
+    }
+  } else {
+    word |= bit;
+    heights_[c] = std::max(heights_[c], r + 1);
+  }
 }
 
-bool Game::doesPieceFit(const Piece& p, int x, int y) const
+// Bring column c's height down to h or below, to the first occupied
+// cell found walking down from row h-1.
+void Game::lowerHeight(int c, int h)
 {
-  if(x + p.getLeftMargin() < 0) {
-    return false;
+  RowWord bit = RowWord(1) << (c & 63);
+  while(h > 0 && !(rowWords(h-1)[c >> 6] & bit)) {
+    --h;
   }
+  heights_[c] = h;
+}
 
-  if(x + 3 - p.getRightMargin() >= board_width_) {
-    return false;
+// Adjust the fill count of row r, tracking when it becomes or stops
+// being full.
+void Game::addToRow(int r, int cells)
+{
+  if(row_fill_[r] == board_width_) {
+    --full_rows_;
   }
 
-  if(y + p.getBottomMargin() < 3) {
-    return false;
+  row_fill_[r] += cells;
+
+  if(row_fill_[r] == board_width_) {
+    ++full_rows_;
+    lowest_full_row_ = std::min(lowest_full_row_, r);
   }
+}
 
-  for(int r = 0; r < 4; ++r) {
-    for(int c = 0; c < 4; ++c) {
-      if(p.isOn(r, c)) {
-        if(get(y-r, x+c) != -1) {
-          return false;
-        }
-      }
-    }
+// Set (or clear) the cells of row r covered by the 4-bit mask placed
+// at column x in the occupancy plane.
+void Game::markRow(int r, int x, unsigned bits, bool on)
+{
+  RowWord* row = rowWords(r);
+  clean_[ r / GameSnapshot::CHUNK_ROWS ] = nullptr;
+
+  Occupancy::RowSpan s = Occupancy::rowSpan(x, bits);
+  RowWord lo = on ? row[s.w] | s.lo : row[s.w] & ~s.lo;
+  rekeyWord(r, s.w, row[s.w], lo);
+  if(s.hi) {
+    RowWord hi = on ? row[s.w+1] | s.hi : row[s.w+1] & ~s.hi;
+    rekeyWord(r, s.w+1, row[s.w+1], hi);
   }
+  Occupancy::markRowSpan(row, s, on);
+}
 
-  return true;
+// Word w of row r is changing from before to after; bring the row's
+// hash and the board's up to date.
+void Game::rekeyWord(int r, int w, RowWord before, RowWord after)
+{
+  uint64_t row_hash = row_hash_[r] ^ wordKey(before, w) ^ wordKey(after, w);
+  hash_ ^= rowKey(row_hash_[r], r) ^ rowKey(row_hash, r);
+  row_hash_[r] = row_hash;
+}
+
+// Row r has been rewritten wholesale; hash it again from its words.
+void Game::rekeyRow(int r)
+{
+  const RowWord* row = rowWords(r);
+  uint64_t row_hash = 0;
+  for(int w = 0; w < words_per_row_; ++w) {
+    row_hash ^= wordKey(row[w], w);
+  }
+  hash_ ^= rowKey(row_hash_[r], r) ^ rowKey(row_hash, r);
+  row_hash_[r] = row_hash;
+}
+
+// Rows [begin,end) are about to be overwritten, or have just been:
+// take their keys out of the board hash, or put them back in.
+void Game::toggleRowKeys(int begin, int end)
+{
+  for(int r = begin; r < end; ++r) {
+    hash_ ^= rowKey(row_hash_[r], r);
+  }
+}
+
+bool Game::doesPieceFit(const Piece& p, int x, int y) const
+{
+  return Occupancy::pieceFits(p, x, y, board_width_, [this](int r) {
+    return rowWords(r);
+  });
 }
 
 void Game::removePiece(const Piece& p, int x, int y) 
 {
   for(int r = 0; r < 4; ++r) {
+    unsigned bits = p.getRowBits(r);
+    if(!bits) {
+      continue;
+    }
+    markRow(y-r, x, bits, false);
+    int cells = 0;
     for(int c = 0; c < 4; ++c) {
-      if(p.isOn(r, c)) {
-        get(y-r, x+c) = -1;
+      if(bits & (1 << c)) {
+        putCell(y-r, x+c, -1);
+        ++cells;
       }
     }
+    addToRow(y-r, -cells);
   }
 }
 
-void Game::removeRow(int y)
+// Call fn(c0, c1) over blocks of columns that together cover the
+// well, on the pool when the well is wide enough to be worth it.
+// Blocks start on word boundaries, so no two share a word.
+template <typename Fn>
+void Game::forColumnBlocks(Fn fn)
 {
-  for(int r = y + 1; r < board_height_ + 4; ++r) {
-    for(int c = 0; c < board_width_; ++c) {
-      get(r-1, c) = get(r, c);
-    }
+  if(!pool_ || board_width_ < PARALLEL_COLUMNS) {
+    fn(0, board_width_);
+    return;
   }
 
-  for(int c = 0; c < board_width_; ++c) {
-    get(board_height_+3, c) = -1;
+  int blocks = (board_width_ + PARALLEL_COLUMNS - 1) / PARALLEL_COLUMNS;
+  pool_->run(blocks, [&](long i, int) {
+    int c0 = int(i) * PARALLEL_COLUMNS;
+    fn(c0, std::min(c0 + PARALLEL_COLUMNS, board_width_));
+  });
+}
+
+// Move rows [begin,end) so they start at row dst.  Only slot numbers
+// move, however wide the rows: the rows in the way are rotated round
+// into the ones left behind, where the caller overwrites or clears
+// them.
+void Game::moveRows(int begin, int end, int dst)
+{
+  if(dst == begin) {
+    return;
   }
+
+  int lo = std::min(begin, dst);
+  int hi = std::max(end, dst + (end - begin));
+  int mid = dst < begin ? begin : end;
+  toggleRowKeys(lo, hi);
+  std::rotate(slot_ + lo, slot_ + mid, slot_ + hi);
+  std::rotate(row_fill_ + lo, row_fill_ + mid, row_fill_ + hi);
+  std::rotate(row_hash_ + lo, row_hash_ + mid, row_hash_ + hi);
+  toggleRowKeys(lo, hi);
+  touchRows(lo, hi);
 }
 
-int Game::collapse() 
+void Game::clearRows(int begin, int end)
 {
-  // This method is implemented in a brain-dead way.  Repeatedly
-  // walk up from the bottom of the well, removing the first full 
-  // row, stopping when there are no more full rows.  It could be
-  // made much faster.  Sue me.
+  forColumnBlocks([&](int c0, int c1) {
+    for(int r = begin; r < end; ++r) {
+      std::fill(rowWords(r) + c0 / 64, rowWords(r) + (c1 + 63) / 64, 0);
+      clearCells(r, c0, c1);
+    }
+  });
+  std::fill(row_fill_ + begin, row_fill_ + end, 0);
+  toggleRowKeys(begin, end);
+  std::fill(row_hash_ + begin, row_hash_ + end, 0);
+  touchRows(begin, end);
+}
 
-  int removed = 0;
+int Game::collapse()
+{
+  beginStep();
+  return removeFullRows();
+}
 
-  while(true) {
-    bool got_one = false;
-    for(int r = 0; r < board_height_ + 4; ++r) {
-      int holes = 0;
+int Game::removeFullRows()
+{
+  // The fill counts already say which rows are full, so walk up once
+  // from the lowest one, sliding the surviving rows down over the
+  // gaps.  Only their slot numbers move: each survivor's slot swaps
+  // with the lowest full row's passed so far, so the full rows' slots
+  // gather above the survivors, where they are cleared, without
+  // being set aside anywhere.
 
-      for(int c = 0; c < board_width_; ++c) {
-        if(get(r, c) == -1) {
-          holes = 1;
-          break;
-        }
-      }
+  if(full_rows_ == 0) {
+    return 0;
+  }
+
+  // Nothing above the highest occupied row has to move.
+  int top = board_height_ + 4;
+  while(row_fill_[top-1] == 0) {
+    --top;
+  }
 
-      if(holes == 0) {
-        got_one = 1;
-        ++removed;
-        removeRow(r);
-        break;
+  int dst = lowest_full_row_;
+  int cleared[4];
+  int num_cleared = 0;
+  if(journaling_) {
+    beginRecord();
+  }
+  toggleRowKeys(lowest_full_row_, top);
+  for(int src = lowest_full_row_; src < top; ++src) {
+    if(row_fill_[src] != board_width_) {
+      std::swap(slot_[dst], slot_[src]);
+      row_fill_[dst] = row_fill_[src];
+      row_hash_[dst] = row_hash_[src];
+      ++dst;
+      continue;
+    }
+
+    if(num_cleared < 4) {
+      cleared[num_cleared] = src;
+    }
+    if(journaling_) {
+      // Nothing has been moved onto this row yet.
+      put<int32_t>(src);
+      for(int c = 0; c < board_width_; ++c) {
+        journal_.push_back(static_cast<unsigned char>(cellAt(src, c)));
       }
     }
+    ++num_cleared;
+  }
+  toggleRowKeys(lowest_full_row_, dst);
+  // The full rows' keys are already out of the board hash.
+  std::fill(row_hash_ + dst, row_hash_ + top, 0);
+  clearRows(dst, top);
+  touchRows(lowest_full_row_, dst);
 
-    if(!got_one) {
-      break;
+  if(journaling_) {
+    // The heights are kept as they stand rather than worked back out,
+    // since set() can leave them counting the falling piece.
+    for(int c = 0; c < board_width_; ++c) {
+      put<int32_t>(heights_[c]);
     }
+    put<int32_t>(num_cleared);
+    journal_.push_back(JOURNAL_ROWS);
   }
 
-  return removed;
+  // Each column drops by the number of cleared rows under its top;
+  // if its top cell was itself cleared, walk down to the next one.
+  // More than four rows only go at once after set() edits, and then
+  // the heights are simply rebuilt.
+  forColumnBlocks([&](int c0, int c1) {
+    for(int c = c0; c < c1; ++c) {
+      int h = heights_[c];
+      if(h <= lowest_full_row_) {
+        continue;
+      }
+      if(num_cleared > 4) {
+        lowerHeight(c, dst);
+        continue;
+      }
+      lowerHeight(c, Occupancy::heightAfterClear(h, cleared, num_cleared));
+    }
+  });
+
+  full_rows_ = 0;
+  lowest_full_row_ = board_height_ + 4;
+  return top - dst;
+}
+
+int Game::landingRow(const Piece& p, int x) const
+{
+  return Occupancy::landingRow(p, x, heights_);
 }
 
 void Game::placePiece(const Piece& p, int x, int y)
 {
   for(int r = 0; r < 4; ++r) {
+    unsigned bits = p.getRowBits(r);
+    if(!bits) {
+      continue;
+    }
+    markRow(y-r, x, bits, true);
+    int cells = 0;
     for(int c = 0; c < 4; ++c) {
-      if(p.isOn(r, c)) {
-        get(y-r, x+c) = p.getColourIndex();
+      if(bits & (1 << c)) {
+        putCell(y-r, x+c, p.getColourIndex());
+        ++cells;
       }
     }
+    addToRow(y-r, cells);
   }
 }
 	
 void Game::generateNewPiece() 
 {
-  piece_ = PIECES[ rand() % 7 ];
+  if(journaling_) {
+    beginRecord();
+    put(pieces_);
+    put(piece_);
+    put<int32_t>(px_);
+    put<int32_t>(py_);
+    journal_.push_back(JOURNAL_SPAWN);
+  }
+
+  piece_ = Piece(pieces_.next());
 
   int xleft = (board_width_-3) / 2;
 
@@ -293,23 +789,65 @@ int Game::tick()
     return -1;
   }
 
+  beginStep();
+  return advance();
+}
+
+int Game::play(const Placement& p)
+{
+  if(stopped_) {
+    return -1;
+  }
+
+  beginStep();
+  removePiece(piece_, px_, py_);
+  journalPiece();
+  piece_ = Piece(piece_.getColourIndex(), p.rotation);
+  px_ = p.x;
+  py_ = p.y;
+  placePiece(piece_, px_, py_);
+  return advance();
+}
+
+// Let the falling piece fall one row, or lock it if it cannot, as
+// tick() does.
+int Game::advance()
+{
   removePiece(piece_, px_, py_);
   int ny = py_ - 1;
 
   if(!doesPieceFit(piece_, px_, ny)) {
     // Must finish off with this piece
     placePiece(piece_, px_, py_);
+    if(journaling_) {
+      beginRecord();
+      for(int c = 0; c < 4; ++c) {
+        put<int32_t>(piece_.getColumnTop(c) >= 0 ? heights_[px_+c] : 0);
+      }
+      journal_.push_back(JOURNAL_LOCK);
+    }
+    for(int c = 0; c < 4; ++c) {
+      int top = piece_.getColumnTop(c);
+      if(top >= 0) {
+        heights_[px_+c] = std::max(heights_[px_+c], py_ - top + 1);
+      }
+    }
     if(py_ >= board_height_) {
       // you lose.
+      if(journaling_) {
+        beginRecord();
+        journal_.push_back(JOURNAL_STOP);
+      }
       stopped_ = true;
       return -1;
     } else {
-      int rm = collapse();
+      int rm = removeFullRows();
       generateNewPiece();
       return rm;
     }
   } else {
     placePiece(piece_, px_, ny);
+    journalPiece();
     py_ = ny;
     return 0;
   }
@@ -326,9 +864,11 @@ bool Game::moveLeft()
 
   int nx = px_ - 1;
 
+  beginStep();
   removePiece(piece_, px_, py_);
   if(doesPieceFit(piece_, nx, py_)) {
     placePiece(piece_, nx, py_);
+    journalPiece();
     px_ = nx;
     return true;
   } else {
@@ -341,9 +881,11 @@ bool Game::moveRight()
 {
   int nx = px_ + 1;
 
+  beginStep();
   removePiece(piece_, px_, py_);
   if(doesPieceFit(piece_, nx, py_)) {
     placePiece(piece_, nx, py_);
+    journalPiece();
     px_ = nx;
     return true;
   } else {
@@ -354,33 +896,142 @@ bool Game::moveRight()
 
 bool Game::drop()
 {
+  beginStep();
   removePiece(piece_, px_, py_);
-  int ny = py_;
 
-  while(true) {
-    --ny;
-    if(!doesPieceFit(piece_, px_, ny)) {
-      break;
+  // From above the stack the landing row comes straight off the
+  // column heights.  A piece already tucked under an overhang has to
+  // feel its way down a row at a time.
+  int ny = landingRow(piece_, px_);
+  if(ny > py_) {
+    ny = py_;
+    while(doesPieceFit(piece_, px_, ny - 1)) {
+      --ny;
     }
   }
 
-  ++ny;
   placePiece(piece_, px_, ny);
 	
   if(ny == py_) {
     return false;
   } else {
+    journalPiece();
     py_ = ny;
     return true;
   }
 }
 
+void Game::enumeratePlacements(std::vector<Placement>& out) const
+{
+  out.clear();
+  if(stopped_) {
+    return;
+  }
+
+  // Scratch copy of the rows under the falling piece with the piece
+  // lifted out; every other row is read from the board as it is.
+  int lo = std::max(py_ - 3, 0);
+  RowWord scratch[4 * 64];
+  int scratch_words = (py_ - lo + 1) * words_per_row_;
+  RowWord* lifted = scratch_words <= 4 * 64 ? scratch : new RowWord[ scratch_words ];
+  for(int r = lo; r <= py_; ++r) {
+    std::copy(rowWords(r), rowWords(r) + words_per_row_,
+              lifted + (r-lo)*words_per_row_);
+  }
+  for(int r = 0; r < 4; ++r) {
+    unsigned bits = piece_.getRowBits(r);
+    int row = py_ - r;
+    if(!bits || row < lo) {
+      continue;
+    }
+    for(int c = 0; c < 4; ++c) {
+      if(bits & (1 << c)) {
+        int col = px_ + c;
+        lifted[ (row-lo)*words_per_row_ + (col >> 6) ] &= ~(RowWord(1) << (col & 63));
+      }
+    }
+  }
+
+  int wpr = words_per_row_;
+  auto rowAt = [=](int r) {
+    return r >= lo && r <= py_ ? lifted + (r-lo)*wpr : rowWords(r);
+  };
+  int kind = piece_.getColourIndex();
+  auto fits = [&](int x, int rot, int y) {
+    return Occupancy::pieceFits(Piece(kind, rot), x, y, board_width_, rowAt);
+  };
+
+  // Anywhere more than three rows above the stack is open space, where
+  // only the walls get in the way, so searching there row by row would
+  // find the same moves over and over.  Start instead at the lowest
+  // row that is still clear of the stack in every orientation.
+  int top = *std::max_element(heights_, heights_ + board_width_);
+  int y0 = std::min(py_, top + 3);
+
+  // States are (x, rotation, y) for y in [0,y0] and x in [-3,width),
+  // numbered so that each row of the search is contiguous.
+  int span = board_width_ + 3;
+  int states = (y0 + 1) * 4 * span;
+  std::vector<RowWord> visited((states + 63) / 64, 0);
+  std::vector<int> queue;
+  queue.reserve(64);
+
+  auto visit = [&](int x, int rot, int y) {
+    int id = (y*4 + rot)*span + x + 3;
+    if(!(visited[id >> 6] & (RowWord(1) << (id & 63)))) {
+      visited[id >> 6] |= RowWord(1) << (id & 63);
+      queue.push_back(id);
+    }
+  };
+
+  visit(px_, piece_.getRotation(), y0);
+
+  for(size_t head = 0; head < queue.size(); ++head) {
+    int id = queue[head];
+    int x = id % span - 3;
+    int rot = (id / span) % 4;
+    int y = id / span / 4;
+
+    if(fits(x - 1, rot, y)) {
+      visit(x - 1, rot, y);
+    }
+    if(fits(x + 1, rot, y)) {
+      visit(x + 1, rot, y);
+    }
+    if(fits(x, (rot + 1) & 3, y)) {
+      visit(x, (rot + 1) & 3, y);
+    }
+    if(fits(x, (rot + 3) & 3, y)) {
+      visit(x, (rot + 3) & 3, y);
+    }
+    if(fits(x, rot, y - 1)) {
+      visit(x, rot, y - 1);
+    } else {
+      Placement p = { y, int16_t(x), uint8_t(rot) };
+      out.push_back(p);
+    }
+  }
+
+  if(lifted != scratch) {
+    delete [] lifted;
+  }
+}
+
+std::vector<Placement> Game::enumeratePlacements() const
+{
+  std::vector<Placement> out;
+  enumeratePlacements(out);
+  return out;
+}
+
 bool Game::rotateCW() 
 {
+  beginStep();
   removePiece(piece_, px_, py_);
   Piece npiece = piece_.rotateCW();
   if(doesPieceFit(npiece, px_, py_)) {
     placePiece(npiece, px_, py_);
+    journalPiece();
     piece_ = npiece;
     return true;
   } else {
@@ -391,10 +1042,12 @@ bool Game::rotateCW()
 
 bool Game::rotateCCW() 
 {
+  beginStep();
   removePiece(piece_, px_, py_);
   Piece npiece = piece_.rotateCCW();
   if(doesPieceFit(npiece, px_, py_)) {
     placePiece(npiece, px_, py_);
+    journalPiece();
     piece_ = npiece;
     return true;
   } else {
@@ -402,3 +1055,340 @@ bool Game::rotateCCW()
     return false;
   }
 }
+
+int Game::numChunks() const
+{
+  int rows = board_height_ + 4;
+  return (rows + GameSnapshot::CHUNK_ROWS - 1) / GameSnapshot::CHUNK_ROWS;
+}
+
+// Rows [begin,end) have been written to, so the chunks holding them no
+// longer match any snapshot.
+void Game::touchRows(int begin, int end) const
+{
+  if(begin >= end) {
+    return;
+  }
+  int first = begin / GameSnapshot::CHUNK_ROWS;
+  int last = (end - 1) / GameSnapshot::CHUNK_ROWS;
+  std::fill(clean_ + first, clean_ + last + 1, nullptr);
+}
+
+// Drop every shared chunk and start keeping track against the given
+// arena instead.
+void Game::forgetChunks(const SnapshotArena* arena,
+                        unsigned long generation) const
+{
+  std::fill(clean_, clean_ + numChunks(), nullptr);
+  clean_arena_ = arena;
+  clean_generation_ = generation;
+}
+
+GameSnapshot Game::snapshot(SnapshotArena& arena) const
+{
+  if(clean_arena_ != &arena || clean_generation_ != arena.getGeneration()) {
+    forgetChunks(&arena, arena.getGeneration());
+  }
+
+  int rows = board_height_ + 4;
+  int chunks = numChunks();
+  size_t chunk_words = GameSnapshot::CHUNK_ROWS * words_per_row_;
+  size_t chunk_bytes = chunk_words * sizeof(RowWord)
+    + GameSnapshot::CHUNK_ROWS * board_width_;
+
+  const char** table = static_cast<const char**>(
+    arena.allocate(chunks * sizeof(const char*)));
+
+  for(int i = 0; i < chunks; ++i) {
+    if(!clean_[i]) {
+      int begin = i * GameSnapshot::CHUNK_ROWS;
+      int end = std::min(begin + GameSnapshot::CHUNK_ROWS, rows);
+
+      bool empty = true;
+      for(int r = begin; r < end; ++r) {
+        if(row_fill_[r]) {
+          empty = false;
+          break;
+        }
+      }
+
+      if(empty) {
+        clean_[i] = &EMPTY_CHUNK;
+      } else {
+        char* chunk = static_cast<char*>(arena.allocate(chunk_bytes));
+        RowWord* words = reinterpret_cast<RowWord*>(chunk);
+        int8_t* colours = reinterpret_cast<int8_t*>(words + chunk_words);
+        for(int r = begin; r < end; ++r) {
+          words = std::copy(rowWords(r), rowWords(r) + words_per_row_, words);
+          if(packed_) {
+            for(int c = 0; c < board_width_; ++c) {
+              *colours++ = cellAt(r, c);
+            }
+          } else {
+            colours = std::copy(rowCells(r), rowCells(r) + board_width_, colours);
+          }
+        }
+        clean_[i] = chunk;
+      }
+    }
+    table[i] = clean_[i];
+  }
+
+  int* heights = static_cast<int*>(arena.allocate(board_width_ * sizeof(int)));
+  std::copy(heights_, heights_ + board_width_, heights);
+
+  GameSnapshot snap;
+  snap.arena = &arena;
+  snap.generation = arena.getGeneration();
+  snap.width = board_width_;
+  snap.height = board_height_;
+  snap.chunks = table;
+  snap.heights = heights;
+  snap.pieces = pieces_;
+  snap.piece = piece_;
+  snap.px = px_;
+  snap.py = py_;
+  snap.stopped = stopped_;
+  snap.full_rows = full_rows_;
+  snap.lowest_full_row = lowest_full_row_;
+  return snap;
+}
+
+bool Game::restore(const GameSnapshot& snap)
+{
+  if(!snap.arena || snap.generation != snap.arena->getGeneration()) {
+    return false;
+  }
+  if(snap.width != board_width_ || snap.height != board_height_) {
+    return false;
+  }
+
+  if(clean_arena_ != snap.arena || clean_generation_ != snap.generation) {
+    forgetChunks(snap.arena, snap.generation);
+  }
+
+  int rows = board_height_ + 4;
+  size_t chunk_words = GameSnapshot::CHUNK_ROWS * words_per_row_;
+
+  for(int i = 0; i < numChunks(); ++i) {
+    const char* chunk = snap.chunks[i];
+    if(clean_[i] == chunk) {
+      continue;
+    }
+
+    int begin = i * GameSnapshot::CHUNK_ROWS;
+    int end = std::min(begin + GameSnapshot::CHUNK_ROWS, rows);
+
+    if(chunk == &EMPTY_CHUNK) {
+      for(int r = begin; r < end; ++r) {
+        std::fill(rowWords(r), rowWords(r) + words_per_row_, 0);
+        clearCells(r, 0, board_width_);
+      }
+      std::fill(row_fill_ + begin, row_fill_ + end, 0);
+      toggleRowKeys(begin, end);
+      std::fill(row_hash_ + begin, row_hash_ + end, 0);
+    } else {
+      const RowWord* words = reinterpret_cast<const RowWord*>(chunk);
+      const int8_t* colours = reinterpret_cast<const int8_t*>(words + chunk_words);
+      for(int r = begin; r < end; ++r) {
+        std::copy(words, words + words_per_row_, rowWords(r));
+        words += words_per_row_;
+        int fill = 0;
+        for(int c = 0; c < board_width_; ++c) {
+          int value = *colours++;
+          putCell(r, c, value);
+          fill += value != -1;
+        }
+        row_fill_[r] = fill;
+        rekeyRow(r);
+      }
+    }
+    clean_[i] = chunk;
+  }
+
+  std::copy(snap.heights, snap.heights + board_width_, heights_);
+  pieces_ = snap.pieces;
+  piece_ = snap.piece;
+  px_ = snap.px;
+  py_ = snap.py;
+  stopped_ = snap.stopped;
+  full_rows_ = snap.full_rows;
+  lowest_full_row_ = snap.lowest_full_row;
+  clearJournal();
+  return true;
+}
+
+void Game::setJournaling(bool on)
+{
+  journaling_ = on;
+  step_open_ = false;
+}
+
+void Game::clearJournal()
+{
+  journal_.clear();
+  step_open_ = false;
+}
+
+// A public call is starting; whatever it records is a new step.
+void Game::beginStep()
+{
+  step_open_ = false;
+}
+
+// Open the current step on its first record.
+void Game::beginRecord()
+{
+  if(!step_open_) {
+    journal_.push_back(JOURNAL_STEP);
+    step_open_ = true;
+  }
+}
+
+template <typename T>
+void Game::put(const T& value)
+{
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+  journal_.insert(journal_.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T Game::take()
+{
+  T value;
+  size_t at = journal_.size() - sizeof(T);
+  std::memcpy(&value, journal_.data() + at, sizeof(T));
+  journal_.resize(at);
+  return value;
+}
+
+// Remember the falling piece where it is, before it moves.
+void Game::journalPiece()
+{
+  if(journaling_) {
+    beginRecord();
+    put(piece_);
+    put<int32_t>(px_);
+    put<int32_t>(py_);
+    journal_.push_back(JOURNAL_MOVE);
+  }
+}
+
+bool Game::undo()
+{
+  if(journal_.empty()) {
+    return false;
+  }
+
+  // Writing to the board while taking records off it would only add
+  // new ones.
+  bool journaling = journaling_;
+  journaling_ = false;
+
+  for(;;) {
+    unsigned char tag = journal_.back();
+    journal_.pop_back();
+    if(tag == JOURNAL_STEP) {
+      break;
+    }
+
+    switch(tag) {
+    case JOURNAL_MOVE: {
+      removePiece(piece_, px_, py_);
+      py_ = take<int32_t>();
+      px_ = take<int32_t>();
+      piece_ = take<Piece>();
+      placePiece(piece_, px_, py_);
+      break;
+    }
+    case JOURNAL_LOCK: {
+      // The piece stays on the board, falling again.
+      for(int c = 3; c >= 0; --c) {
+        int h = take<int32_t>();
+        if(piece_.getColumnTop(c) >= 0) {
+          heights_[px_+c] = h;
+        }
+      }
+      break;
+    }
+    case JOURNAL_STOP:
+      stopped_ = false;
+      break;
+    case JOURNAL_SPAWN: {
+      removePiece(piece_, px_, py_);
+      py_ = take<int32_t>();
+      px_ = take<int32_t>();
+      piece_ = take<Piece>();
+      pieces_ = take<PieceSource>();
+      break;
+    }
+    case JOURNAL_ROWS: {
+      int count = take<int32_t>();
+      size_t at = journal_.size() - board_width_ * sizeof(int32_t);
+      std::memcpy(heights_, journal_.data() + at, board_width_ * sizeof(int32_t));
+      journal_.resize(at);
+      at -= count * (sizeof(int32_t) + board_width_);
+      restoreRows(journal_.data() + at, count);
+      journal_.resize(at);
+      break;
+    }
+    case JOURNAL_CELL: {
+      int h = take<int32_t>();
+      int value = take<int8_t>();
+      int c = take<int32_t>();
+      int r = take<int32_t>();
+      set(r, c, value);
+      heights_[c] = h;
+      break;
+    }
+    }
+  }
+
+  journaling_ = journaling;
+  step_open_ = false;
+  return true;
+}
+
+// Put back count full rows that removeFullRows() took out, saved as
+// each row's old index followed by its colours, lowest row first.
+// The column heights are left to the caller.
+void Game::restoreRows(const unsigned char* saved, int count)
+{
+  size_t stride = sizeof(int32_t) + board_width_;
+  std::vector<int> index(count);
+  for(int i = 0; i < count; ++i) {
+    int32_t r;
+    std::memcpy(&r, saved + i*stride, sizeof(r));
+    index[i] = r;
+  }
+
+  int top = board_height_ + 4 - count;
+  while(top > 0 && row_fill_[top-1] == 0) {
+    --top;
+  }
+
+  // Lift the run of rows that sat above each removed row back up over
+  // it, highest run first so nothing is overwritten before it moves.
+  for(int i = count - 1; i >= 0; --i) {
+    int begin = index[i] - i;
+    int end = i + 1 < count ? index[i+1] - (i + 1) : top;
+    moveRows(begin, end, index[i] + 1);
+  }
+
+  for(int i = 0; i < count; ++i) {
+    int r = index[i];
+    const unsigned char* colours = saved + i*stride + sizeof(int32_t);
+    RowWord* row = rowWords(r);
+    std::fill(row, row + words_per_row_, 0);
+    for(int c = 0; c < board_width_; ++c) {
+      putCell(r, c, static_cast<int8_t>(colours[c]));
+      row[c >> 6] |= RowWord(1) << (c & 63);
+    }
+    row_fill_[r] = board_width_;
+    rekeyRow(r);
+  }
+  touchRows(index[0], top + count);
+
+  full_rows_ = count;
+  lowest_full_row_ = index[0];
+}
@@ -12,32 +12,177 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "piecesource.h"
+
+class SnapshotArena;
+class WorkPool;
+
+// One orientation of a piece: its cells as a 16-bit mask, with bit
+// r*4+c set when row r, column c of the 4x4 box is on, plus the number
+// of empty columns/rows on each side (left, top, right, bottom), and
+// the first and last row that is on in each column (-1 for an empty
+// column).
+struct PieceShape {
+  uint16_t mask;
+  int8_t margins[4];
+  int8_t top[4];
+  int8_t bottom[4];
+};
+
+// Every orientation of the seven pieces, built at compile time.
+// PIECE_SHAPES[k][n] is piece k turned clockwise n times; k doubles as
+// the piece's colour index.
+extern const PieceShape PIECE_SHAPES[7][4];
+
+// A piece is just an index into PIECE_SHAPES, so rotating one is an
+// index change and copying one is two bytes.
 class Piece {
 public:
-  Piece();
-  Piece(const char *desc, int cindex, 
-         int left, int top, int right, int bottom);
+  Piece()
+    : kind_(0)
+    , rotation_(0)
+  {}
+  explicit Piece(int kind, int rotation = 0)
+    : kind_(kind)
+    , rotation_(rotation & 3)
+  {}
 
-  Piece& operator =(const Piece& other);
+  int getLeftMargin() const
+  {
+    return shape().margins[0];
+  }
+  int getTopMargin() const
+  {
+    return shape().margins[1];
+  }
+  int getRightMargin() const
+  {
+    return shape().margins[2];
+  }
+  int getBottomMargin() const
+  {
+    return shape().margins[3];
+  }
+  int getColourIndex() const
+  {
+    return kind_;
+  }
+  int getRotation() const
+  {
+    return rotation_;
+  }
 
-  int getLeftMargin() const;
-  int getTopMargin() const;
-  int getRightMargin() const;
-  int getBottomMargin() const;
-  int getColourIndex() const;
+  Piece rotateCW() const
+  {
+    return Piece(kind_, rotation_ + 1);
+  }
+  Piece rotateCCW() const
+  {
+    return Piece(kind_, rotation_ + 3);
+  }
 
-  Piece rotateCW() const;
-  Piece rotateCCW() const;
+  bool isOn(int row, int col) const
+  {
+    return (shape().mask >> (row*4 + col)) & 1;
+  }
 
-  bool isOn(int row, int col) const;
+  // The highest and lowest row that is on in the given column, or -1
+  // if the column is empty.  Rows count down from the top of the box.
+  int getColumnTop(int col) const
+  {
+    return shape().top[col];
+  }
+  int getColumnBottom(int col) const
+  {
+    return shape().bottom[col];
+  }
+
+  // The cells of the given row as a 4-bit mask, bit c set when
+  // column c is on.  This is what the collision test consumes.
+  unsigned getRowBits(int row) const
+  {
+    return (shape().mask >> (row*4)) & 0xf;
+  }
 
 private:
-  void getColumn(int col, char *buf) const;
-  void getColumnRev(int col, char *buf) const;
+  const PieceShape& shape() const
+  {
+    return PIECE_SHAPES[kind_][rotation_];
+  }
+
+  unsigned char kind_;
+  unsigned char rotation_;
+};
+
+// One machine word of the occupancy plane.  Bit b of word w in a row
+// is set when column w*64 + b of that row is occupied.
+typedef uint64_t RowWord;
+
+// A place the falling piece can come to rest: its top-left corner at
+// column x and row y, turned clockwise rotation times from how it
+// spawned.
+struct Placement {
+  int32_t y;
+  int16_t x;
+  uint8_t rotation;
+};
+
+// A frozen copy of a game, taken by Game::snapshot() and brought back
+// by Game::restore().  The well is held as chunks of CHUNK_ROWS rows
+// allocated from a SnapshotArena, and a chunk that did not change
+// since the last snapshot from the same arena is shared rather than
+// copied, so a search tree of snapshots costs little more than the
+// rows each node actually touched.  A snapshot is a small value that
+// may be copied freely, but it is only good until its arena is
+// cleared or destroyed.  The fields belong to Game.
+struct GameSnapshot {
+  static const int CHUNK_ROWS = 8;
+
+  GameSnapshot()
+    : arena(nullptr)
+    , generation(0)
+    , width(0)
+    , height(0)
+    , chunks(nullptr)
+    , heights(nullptr)
+    , px(0)
+    , py(0)
+    , stopped(false)
+    , full_rows(0)
+    , lowest_full_row(0)
+  {}
+
+  const SnapshotArena* arena;
+  unsigned long generation;
+
+  int width;
+  int height;
+
+  // One per chunk: the chunk's occupancy words followed by one signed
+  // byte of colour per cell, or Game's shared empty chunk.
+  const char* const* chunks;
+  const int* heights;
+
+  PieceSource pieces;
+  Piece piece;
+  int px;
+  int py;
+  bool stopped;
+  int full_rows;
+  int lowest_full_row;
+};
 
-  char desc_[16];
-  int cindex_;
-  int margins_[4];
+// How a game keeps the colour of each cell.  CELLS_WIDE spends an
+// int per cell.  CELLS_PACKED spends four bits, for holding very many
+// games at once, at the price of a little more work per cell written.
+// Play is the same either way; only get() reads the colours.
+enum CellStorage {
+  CELLS_WIDE,
+  CELLS_PACKED
 };
 
 class Game
@@ -45,14 +190,26 @@ class Game
 public:
   // Create a new game instance with a well of the given dimensions.
   // Note that internally, the board has four extra rows, to hold a 
-  // piece that has just begun to fall.
-  Game(int width, int height);
+  // piece that has just begun to fall.  Pieces are taken from the
+  // given source, so the same seed plays out the same game.  Cell
+  // colours are kept as storage says.
+  Game(int width, int height, const PieceSource& pieces = PieceSource(),
+       CellStorage storage = CELLS_WIDE);
 
+  // Games are values: a copy is a separate game in the same state.  A
+  // moved-from game may only be assigned to or destroyed.
+  Game(const Game& other);
+  Game(Game&& other) noexcept;
+  Game& operator =(Game other);
   ~Game();
 
+  void swap(Game& other) noexcept;
+
   // Set the game to an initial state -- empty well, one piece waiting
-  // on top.
+  // on top.  The piece stream carries on from where it was, unless a
+  // new seed is given.
   void reset();
+  void reset(uint64_t seed);
 
   // Advance the game by one tick.  This usually just pushes the 
   // currently falling piece down by one row.  It can sometimes cause
@@ -78,6 +235,34 @@ public:
   bool rotateCW();
   bool rotateCCW();
 
+  // The falling piece and the column and row of its top-left corner.
+  const Piece& getPiece() const
+  {
+    return piece_;
+  }
+  int getPieceX() const
+  {
+    return px_;
+  }
+  int getPieceY() const
+  {
+    return py_;
+  }
+
+  // Whether the game is over.  The last piece has then locked where
+  // it stopped, and tick() does nothing more.
+  bool isStopped() const
+  {
+    return stopped_;
+  }
+
+  // Where the pieces come from, including the preview of what is
+  // coming next.
+  const PieceSource& getPieceSource() const
+  {
+    return pieces_;
+  }
+
   int getWidth() const
   { 
     return board_width_;
@@ -86,6 +271,14 @@ public:
   {
     return board_height_;
   }
+  CellStorage getCellStorage() const
+  {
+    return packed_ ? CELLS_PACKED : CELLS_WIDE;
+  }
+
+  // Bytes this game holds on to, counting the object itself, the well
+  // and the undo journal.
+  size_t getMemoryUsage() const;
 
   // Get the contents of the cell at row r and column c.  Returns
   // the following values:
@@ -97,18 +290,170 @@ public:
   // rows are added on to accommodate new pieces that are falling into
   // the well.
   int get(int r, int c) const;
-  int& get(int r, int c);
 
-private:
+  // Overwrite the cell at row r and column c with a value in the same
+  // range that get() returns, keeping the occupancy plane in step.
+  void set(int r, int c, int value);
+
+  // Would piece p fit with its top-left corner at column x and row y
+  // (rows counting up from the bottom of the well)?  Only the occupancy
+  // plane is consulted, so the falling piece must be lifted off the
+  // board first if it is not meant to collide with itself.
   bool doesPieceFit(const Piece& p, int x, int y) const;
 
-  void removeRow(int y);
+  // The row y at which piece p would come to rest if dropped straight
+  // down column x from above the stack, read off the column heights
+  // rather than searched for.  The falling piece is not part of the
+  // stack.  x must be a column at which p fits between the walls.
+  int landingRow(const Piece& p, int x) const;
+
+  // Height of the stack in column c: one more than the highest locked
+  // cell, or 0 for an empty column.
+  int getColumnHeight(int c) const
+  {
+    return heights_[c];
+  }
+
+  // The occupancy plane's words for row r, getWordsPerRow() of them,
+  // falling piece included.  See RowWord.  Rows are stored apart, so
+  // the next row's words do not follow on from these.
+  const RowWord* getRowWords(int r) const
+  {
+    return rowWords(r);
+  }
+  int getWordsPerRow() const
+  {
+    return words_per_row_;
+  }
+
+  // A 64-bit hash of which cells are occupied, falling piece
+  // included, kept up to date as the board changes.  Equal boards
+  // always hash alike, whatever moves led to them.
+  uint64_t getHash() const
+  {
+    return hash_;
+  }
+
+  // Every place the falling piece can reach and come to rest in, by
+  // any sequence of moveLeft, moveRight, rotateCW, rotateCCW and tick.
+  // Nothing on the board is touched.  The second form reuses out's
+  // storage, for callers that enumerate over and over.
+  std::vector<Placement> enumeratePlacements() const;
+  void enumeratePlacements(std::vector<Placement>& out) const;
+
+  // Lock the falling piece at p, one of the placements that
+  // enumeratePlacements() found, as if it had been steered there.
+  // Returns what tick() returns for the lock.
+  int play(const Placement& p);
+
+  // Freeze the current state into arena.  Rows that have not changed
+  // since this game last snapshotted into (or restored from) the same
+  // arena are shared with that snapshot instead of copied.  Not safe
+  // to call on one game from two threads at once.
+  GameSnapshot snapshot(SnapshotArena& arena) const;
+
+  // Return to the state held in snap, rewriting only the rows that
+  // differ from what this game last saw in snap's arena.  Returns
+  // false, changing nothing, if snap is for a well of another size or
+  // its arena has been cleared since.
+  bool restore(const GameSnapshot& snap);
+
+  // While journaling is on, every change to the game is written to a
+  // journal: piece moves, pieces locking and spawning, rows removed
+  // and cells overwritten by set().  undo() then takes back the most
+  // recent call to tick, play, moveLeft, moveRight, drop, rotateCW,
+  // rotateCCW or set that changed anything, in
+  // time proportional to what that call changed.  It returns false
+  // when there is nothing left to undo.  reset() and restore() start
+  // the journal over, since neither can be taken back.
+  void setJournaling(bool on);
+  bool isJournaling() const
+  {
+    return journaling_;
+  }
+  bool undo();
+  void clearJournal();
+
+  // Bytes the journal is holding on to.
+  size_t getJournalSize() const
+  {
+    return journal_.size();
+  }
+
+  // Split the per-column work of clearing lines in very wide wells,
+  // PARALLEL_COLUMNS or more, between the workers of pool, or do it
+  // all on the calling thread if pool is null (the default).  The
+  // pool must outlive the game and any copies of it, and must not be
+  // running anything else when the game clears lines.
+  static const int PARALLEL_COLUMNS = 4096;
+  void setWorkPool(WorkPool* pool)
+  {
+    pool_ = pool;
+  }
+
+private:
+  // The benchmarks time collapse() on its own through this.
+  friend struct GameProbe;
+
+  // Remove every full row, moving the rows above down to close the
+  // gaps, as one undoable step.  Returns the number of rows removed.
+  // Only safe when the falling piece is not part of a full row, as it
+  // is never when a piece has just locked; it is private so that set()
+  // cannot be used to build a row that would cut the piece in two.
   int collapse();
 
+  void markRow(int r, int x, unsigned bits, bool on);
+  void addToRow(int r, int cells);
+
+  void moveRows(int begin, int end, int dst);
+  void clearRows(int begin, int end);
+  void lowerHeight(int c, int h);
+
+  void rekeyWord(int r, int w, RowWord before, RowWord after);
+  void rekeyRow(int r);
+  void toggleRowKeys(int begin, int end);
+
   void removePiece(const Piece& p, int x, int y);
   void placePiece(const Piece& p, int x, int y);
 
   void generateNewPiece();
+  int advance();
+
+  int removeFullRows();
+  void restoreRows(const unsigned char* saved, int count);
+
+  void beginStep();
+  void beginRecord();
+  template <typename T> void put(const T& value);
+  template <typename T> T take();
+  void journalPiece();
+
+  RowWord* rowWords(int r) const
+  {
+    return rows_ + size_t(slot_[r])*words_per_row_;
+  }
+  int* rowCells(int r) const
+  {
+    return board_ + size_t(slot_[r])*board_width_;
+  }
+  unsigned char* rowPacked(int r) const
+  {
+    return packed_ + size_t(slot_[r])*packedRowBytes();
+  }
+  size_t packedRowBytes() const
+  {
+    return (board_width_ + 1) / 2;
+  }
+
+  int cellAt(int r, int c) const;
+  void putCell(int r, int c, int value);
+  void clearCells(int r, int c0, int c1);
+
+  template <typename Fn> void forColumnBlocks(Fn fn);
+
+  int numChunks() const;
+  void touchRows(int begin, int end) const;
+  void forgetChunks(const SnapshotArena* arena, unsigned long generation) const;
 
 private:
   int board_width_;
@@ -116,11 +461,62 @@ private:
 
   bool stopped_;
 
+  PieceSource pieces_;
+
   Piece piece_;
   int px_;
   int py_;
 
+  // Occupancy plane, words_per_row_ words for each of the
+  // board_height_+4 rows.  All game logic runs on this.
+  int words_per_row_;
+  RowWord* rows_;
+
+  // Colour plane, only kept for get().  With CELLS_WIDE it is board_,
+  // one int per cell.  With CELLS_PACKED it is packed_, a nibble per
+  // cell holding the colour plus one, even columns in the low nibble,
+  // so an empty row is all zero bytes.  The other pointer is null.
   int* board_;
+  unsigned char* packed_;
+
+  // Both planes are kept in slots of one row each, and row r lives in
+  // slot slot_[r].  Clearing a line reorders the slot numbers of the
+  // rows above it instead of copying their cells down, so the cost
+  // does not grow with the width of the well.
+  int* slot_;
+
+  // Occupied cells in each row, so full rows are known without
+  // scanning.  full_rows_ counts rows at board_width_, and no row
+  // below lowest_full_row_ is full.
+  int* row_fill_;
+  int full_rows_;
+  int lowest_full_row_;
+
+  // Skyline of the locked cells, one entry per column.  Raised when a
+  // piece locks and lowered when rows are cleared.
+  int* heights_;
+
+  // Hash of each row's occupied cells, and the board hash built from
+  // them.  See getHash().
+  uint64_t* row_hash_;
+  uint64_t hash_;
+
+  // For each chunk of GameSnapshot::CHUNK_ROWS rows, the chunk in
+  // clean_arena_ that it last matched, or null once it has been
+  // written to since.  Kept by snapshot() and restore(), cleared by
+  // every write to the board.
+  mutable const char** clean_;
+  mutable const SnapshotArena* clean_arena_;
+  mutable unsigned long clean_generation_;
+
+  // The undo journal: records of the changes made, newest last, each
+  // its fields followed by a one byte tag so it can be read from the
+  // back.  Every call's records are preceded by a step tag.
+  bool journaling_;
+  bool step_open_;
+  std::vector<unsigned char> journal_;
+
+  WorkPool* pool_;
 };
 
 #endif // GAME_H
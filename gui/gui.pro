@@ -0,0 +1,11 @@
+# a1: the game.  Built into the top directory so it runs next to the
+# shaders it loads.
+TEMPLATE = app
+TARGET = a1
+QT += widgets
+DESTDIR = $$PWD/..
+
+include(../engine/engine.pri)
+
+HEADERS += ../renderer.h ../rollingtimes.h ../window.h
+SOURCES += ../main.cpp ../renderer.cpp ../rollingtimes.cpp ../window.cpp
@@ -0,0 +1,169 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Heuristic - how the autoplayer scores a well once a piece has
+ * locked.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "boardeval.h"
+#include "game.h"
+#include "heuristic.h"
+
+namespace {
+
+// The locked cells of row r into out: its occupancy words with the
+// falling piece lifted off, unless the game is over and the piece
+// has locked where it stopped.
+void lockedRow(const Game& game, int r, RowWord* out)
+{
+  const RowWord* words = game.getRowWords(r);
+  std::copy(words, words + game.getWordsPerRow(), out);
+
+  int y = game.getPieceY();
+  if(game.isStopped() || r > y || r <= y - 4) {
+    return;
+  }
+  unsigned bits = game.getPiece().getRowBits(y - r);
+  for(int c = 0; c < 4; ++c) {
+    if(bits & (1 << c)) {
+      int col = game.getPieceX() + c;
+      out[col / 64] &= ~(RowWord(1) << (col % 64));
+    }
+  }
+}
+
+// The same features cell by cell, for wells too wide for the kernel,
+// over the given rows of which the stack fills the lowest top.
+BoardFeatures measureWideBoard(const Game& game, int rows, int top)
+{
+  BoardFeatures f = BoardFeatures();
+  int width = game.getWidth();
+  int words = game.getWordsPerRow();
+  std::vector<RowWord> below(words, ~RowWord(0));
+  std::vector<RowWord> row(words);
+  auto filled = [](const std::vector<RowWord>& w, int c) {
+    return ((w[c / 64] >> (c % 64)) & 1) != 0;
+  };
+
+  for(int r = 0; r < rows; ++r) {
+    lockedRow(game, r, row.data());
+    bool left = true;
+    for(int c = 0; c < width; ++c) {
+      bool on = filled(row, c);
+      f.holes += !on && r < game.getColumnHeight(c);
+      f.row_transitions += r < top && on != left;
+      f.column_transitions += on != filled(below, c);
+      left = on;
+    }
+    f.row_transitions += r < top && !left;
+    row.swap(below);
+  }
+
+  f.max_height = top;
+  for(int c = 0; c < width; ++c) {
+    int h = game.getColumnHeight(c);
+    f.aggregate_height += h;
+
+    if(c > 0) {
+      f.bumpiness += std::abs(h - game.getColumnHeight(c - 1));
+    }
+
+    int left = c > 0 ? game.getColumnHeight(c - 1) : -1;
+    int right = c + 1 < width ? game.getColumnHeight(c + 1) : -1;
+    int rim = left < 0 ? right : right < 0 ? left : std::min(left, right);
+    if(rim > h) {
+      f.wells += rim - h;
+    }
+  }
+
+  return f;
+}
+
+} // namespace
+
+BoardFeatures measureBoard(const Game& game)
+{
+  int width = game.getWidth();
+  int top = 0;
+  for(int c = 0; c < width; ++c) {
+    top = std::max(top, game.getColumnHeight(c));
+  }
+  // The row over the stack as well, so every column's top is a
+  // column transition.
+  int rows = std::min(top + 1, game.getHeight() + 4);
+
+  if(width > 64) {
+    return measureWideBoard(game, rows, top);
+  }
+
+  // One word per row, copied out with the falling piece lifted off
+  // the copy.  Called from many threads at once, so tall wells copy
+  // into a buffer of each thread's own.
+  const int SHORT_ROWS = 64;
+  RowWord short_rows[SHORT_ROWS];
+  static thread_local std::vector<RowWord> tall_rows;
+  RowWord* words = short_rows;
+  if(rows > SHORT_ROWS) {
+    tall_rows.resize(rows);
+    words = tall_rows.data();
+  }
+  for(int r = 0; r < rows; ++r) {
+    words[r] = *game.getRowWords(r);
+  }
+
+  int y = game.getPieceY();
+  for(int r = std::max(y - 3, 0); !game.isStopped() && r <= y && r < rows; ++r) {
+    RowWord bits = game.getPiece().getRowBits(y - r);
+    int x = game.getPieceX();
+    words[r] &= ~(x < 0 ? bits >> -x : bits << x);
+  }
+
+  BoardEval e;
+  evaluateBoard(words, rows, width, e);
+
+  BoardFeatures f;
+  f.aggregate_height = e.aggregate_height;
+  f.holes = e.holes;
+  f.bumpiness = e.bumpiness;
+  f.wells = e.wells;
+  f.max_height = e.max_height;
+  f.row_transitions = e.row_transitions;
+  f.column_transitions = e.column_transitions;
+  return f;
+}
+
+WeightedHeuristic::Weights WeightedHeuristic::defaults()
+{
+  Weights w;
+  w.aggregate_height = -0.510066;
+  w.holes = -0.35663;
+  w.bumpiness = -0.184483;
+  w.wells = -0.05;
+  // Not weighed by default; there for tuning.
+  w.row_transitions = 0;
+  w.column_transitions = 0;
+  w.lines = 0.760666;
+  return w;
+}
+
+WeightedHeuristic::WeightedHeuristic(const Weights& weights)
+  : weights_(weights)
+{
+}
+
+double WeightedHeuristic::evaluate(const Game& game, int lines) const
+{
+  BoardFeatures f = measureBoard(game);
+  return weights_.aggregate_height * f.aggregate_height
+    + weights_.holes * f.holes
+    + weights_.bumpiness * f.bumpiness
+    + weights_.wells * f.wells
+    + weights_.row_transitions * f.row_transitions
+    + weights_.column_transitions * f.column_transitions
+    + weights_.lines * lines;
+}
@@ -0,0 +1,79 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Heuristic - how the autoplayer scores a well once a piece has
+ * locked.  Bots take any Heuristic; WeightedHeuristic is the usual
+ * linear mix of board features.
+ */
+
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+
+class Game;
+
+// The board features a heuristic usually weighs, read off the locked
+// cells only; the falling piece does not count.  Wells up to 64
+// columns wide are measured by the vector kernel in boardeval.h.
+struct BoardFeatures {
+  // Sum of the column heights.
+  int aggregate_height;
+  // Empty cells with a locked cell somewhere above them.
+  int holes;
+  // Sum of the height differences between neighbouring columns.
+  int bumpiness;
+  // Sum over columns lower than both neighbours (walls count as
+  // infinitely high) of how much lower.
+  int wells;
+  // Height of the tallest column.
+  int max_height;
+  // Filled/empty changes along each row up to the tallest column, the
+  // walls counting as filled.
+  int row_transitions;
+  // Filled/empty changes up each column, the floor counting as filled
+  // and the top of each column's stack counting as one.
+  int column_transitions;
+};
+
+BoardFeatures measureBoard(const Game& game);
+
+class Heuristic
+{
+public:
+  virtual ~Heuristic() {}
+
+  // Score the game, higher being better, given that lines rows were
+  // cleared on the way to it.  Called from many threads at once.
+  virtual double evaluate(const Game& game, int lines) const = 0;
+};
+
+class WeightedHeuristic : public Heuristic
+{
+public:
+  struct Weights {
+    double aggregate_height;
+    double holes;
+    double bumpiness;
+    double wells;
+    double row_transitions;
+    double column_transitions;
+    double lines;
+  };
+
+  // Weights that keep the stack low and flat and clear steadily.
+  static Weights defaults();
+
+  explicit WeightedHeuristic(const Weights& weights = defaults());
+
+  double evaluate(const Game& game, int lines) const override;
+
+  const Weights& getWeights() const
+  {
+    return weights_;
+  }
+
+private:
+  Weights weights_;
+};
+
+#endif // HEURISTIC_H
@@ -0,0 +1,295 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * InputLog - recording and playing back the inputs of one game.
+ */
+
+#include <cstring>
+
+#include "inputlog.h"
+
+namespace {
+
+// "TLOG" and the format version, ahead of the header varints.
+const unsigned char MAGIC[5] = { 'T', 'L', 'O', 'G', 1 };
+
+// Each event is a varint of its run length shifted over the action.
+// A zero varint ends the events.
+const int ACTION_BITS = 3;
+
+// Wells with more cells than this in a log are taken to be corrupt
+// rather than allocated.
+const uint64_t MAX_CELLS = uint64_t(1) << 28;
+
+// Longer runs of a key press than this are taken to be corrupt.  Runs
+// of ticks may be any length, since they stop costing anything once
+// the game is over.
+const uint64_t MAX_RUN = uint64_t(1) << 20;
+
+inline uint64_t mixBits(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t zigzag(int64_t v)
+{
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v)
+{
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+// Reads varints off a log, failing once it runs past the end.
+class Reader
+{
+public:
+  Reader(const unsigned char* data, size_t size)
+    : at_(data)
+    , end_(data + size)
+    , ok_(true)
+  {}
+
+  uint64_t varint()
+  {
+    uint64_t value = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+      if(at_ == end_) {
+        ok_ = false;
+        return 0;
+      }
+      unsigned char b = *at_++;
+      value |= uint64_t(b & 0x7f) << shift;
+      if(!(b & 0x80)) {
+        return value;
+      }
+    }
+    ok_ = false;
+    return 0;
+  }
+
+  bool bytes(void* out, size_t n)
+  {
+    if(size_t(end_ - at_) < n) {
+      ok_ = false;
+      return false;
+    }
+    std::memcpy(out, at_, n);
+    at_ += n;
+    return true;
+  }
+
+  bool ok() const
+  {
+    return ok_;
+  }
+  bool atEnd() const
+  {
+    return at_ == end_;
+  }
+
+private:
+  const unsigned char* at_;
+  const unsigned char* end_;
+  bool ok_;
+};
+
+// Whether p is a placement the falling piece can reach and rest in.
+// play() trusts its caller, so a corrupt log must not reach it with
+// anything else.  moves is scratch space, reused between calls.
+bool isReachable(const Game& game, const Placement& p,
+                 std::vector<Placement>& moves)
+{
+  game.enumeratePlacements(moves);
+  for(const Placement& m : moves) {
+    if(m.x == p.x && m.y == p.y && m.rotation == p.rotation) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+int applyInput(Game& game, InputAction action)
+{
+  switch(action) {
+  case INPUT_TICK: return game.tick();
+  case INPUT_LEFT: return game.moveLeft();
+  case INPUT_RIGHT: return game.moveRight();
+  case INPUT_ROTATE_CW: return game.rotateCW();
+  case INPUT_ROTATE_CCW: return game.rotateCCW();
+  case INPUT_DROP: return game.drop();
+  case INPUT_RESET: game.reset(); return 0;
+  case INPUT_PLAY: break;
+  }
+  return 0;
+}
+
+uint64_t hashGameState(const Game& game)
+{
+  const PieceSource& pieces = game.getPieceSource();
+  uint64_t h = mixBits(game.getHash() + 1);
+  h = mixBits(h ^ uint64_t(game.getPiece().getColourIndex() * 4
+                           + game.getPiece().getRotation()));
+  h = mixBits(h ^ zigzag(game.getPieceX()));
+  h = mixBits(h ^ zigzag(game.getPieceY()));
+  h = mixBits(h ^ uint64_t(game.isStopped()));
+  for(int i = 0; i < pieces.getLookahead(); ++i) {
+    h = mixBits(h ^ uint64_t(pieces.peek(i)));
+  }
+  return h;
+}
+
+InputRecorder::InputRecorder(const Game& game)
+  : run_action_(INPUT_TICK)
+  , run_length_(0)
+{
+  const PieceSource& pieces = game.getPieceSource();
+  bytes_.assign(MAGIC, MAGIC + sizeof(MAGIC));
+  putVarint(game.getWidth());
+  putVarint(game.getHeight());
+  putVarint(pieces.getSeed());
+  putVarint(pieces.getMode());
+  putVarint(pieces.getLookahead());
+}
+
+void InputRecorder::record(InputAction action)
+{
+  if(action != run_action_) {
+    flushRun();
+    run_action_ = action;
+  }
+  ++run_length_;
+}
+
+void InputRecorder::recordPlay(const Placement& p)
+{
+  flushRun();
+  putVarint((uint64_t(1) << ACTION_BITS) | INPUT_PLAY);
+  putVarint(zigzag(p.x));
+  putVarint(zigzag(p.y));
+  putVarint(p.rotation);
+}
+
+const std::vector<unsigned char>& InputRecorder::finish(const Game& game)
+{
+  flushRun();
+  putVarint(0);
+  uint64_t hash = hashGameState(game);
+  for(int i = 0; i < 8; ++i) {
+    bytes_.push_back(static_cast<unsigned char>(hash >> (i * 8)));
+  }
+  return bytes_;
+}
+
+void InputRecorder::flushRun()
+{
+  if(run_length_) {
+    putVarint((run_length_ << ACTION_BITS) | run_action_);
+    run_length_ = 0;
+  }
+}
+
+void InputRecorder::putVarint(uint64_t value)
+{
+  while(value >= 0x80) {
+    bytes_.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<unsigned char>(value));
+}
+
+bool replayInputLog(const unsigned char* data, size_t size,
+                    ReplayResult& result)
+{
+  Reader in(data, size);
+
+  unsigned char magic[sizeof(MAGIC)];
+  if(!in.bytes(magic, sizeof(magic))
+     || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    return false;
+  }
+
+  uint64_t width = in.varint();
+  uint64_t height = in.varint();
+  uint64_t seed = in.varint();
+  uint64_t mode = in.varint();
+  uint64_t lookahead = in.varint();
+  if(!in.ok() || width < 4 || width > uint64_t(INT16_MAX)
+     || height < 1 || height > MAX_CELLS
+     || width > MAX_CELLS / (height + 4) || mode > PieceSource::BAG
+     || lookahead < 1 || lookahead > PieceSource::MAX_LOOKAHEAD) {
+    return false;
+  }
+
+  Game game(int(width), int(height),
+            PieceSource(seed, PieceSource::Mode(mode), int(lookahead)));
+  result.width = int(width);
+  result.height = int(height);
+  result.inputs = 0;
+  result.ticks = 0;
+  result.lines = 0;
+  std::vector<Placement> moves;
+
+  for(;;) {
+    uint64_t event = in.varint();
+    if(!in.ok()) {
+      return false;
+    }
+    if(event == 0) {
+      break;
+    }
+
+    int action = int(event & ((1 << ACTION_BITS) - 1));
+    uint64_t count = event >> ACTION_BITS;
+    result.inputs += long(count);
+
+    if(action == INPUT_PLAY) {
+      Placement p;
+      p.x = int16_t(unzigzag(in.varint()));
+      p.y = int32_t(unzigzag(in.varint()));
+      p.rotation = uint8_t(in.varint());
+      if(!in.ok() || count != 1 || !isReachable(game, p, moves)) {
+        return false;
+      }
+      int rm = game.play(p);
+      if(rm > 0) {
+        result.lines += rm;
+      }
+    } else if(action == INPUT_TICK) {
+      // Ticks after the game ends change nothing, so skip them.
+      for(uint64_t i = 0; i < count && !game.isStopped(); ++i) {
+        int rm = game.tick();
+        if(rm > 0) {
+          result.lines += rm;
+        }
+      }
+      result.ticks += long(count);
+    } else if(action <= INPUT_RESET) {
+      if(count > MAX_RUN) {
+        return false;
+      }
+      for(uint64_t i = 0; i < count; ++i) {
+        applyInput(game, InputAction(action));
+      }
+    } else {
+      return false;
+    }
+  }
+
+  unsigned char hash[8];
+  if(!in.bytes(hash, sizeof(hash)) || !in.atEnd()) {
+    return false;
+  }
+  result.expected_hash = 0;
+  for(int i = 0; i < 8; ++i) {
+    result.expected_hash |= uint64_t(hash[i]) << (i * 8);
+  }
+  result.hash = hashGameState(game);
+  return true;
+}
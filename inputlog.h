@@ -0,0 +1,95 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * InputLog - a compact record of everything done to one game, from
+ * which the game can be played back exactly, and the player that does
+ * so as fast as the engine allows.
+ */
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// The calls on a game that an input log records.  INPUT_PLAY carries
+// the placement that was played, as the autoplayer does.
+enum InputAction {
+  INPUT_TICK,
+  INPUT_LEFT,
+  INPUT_RIGHT,
+  INPUT_ROTATE_CW,
+  INPUT_ROTATE_CCW,
+  INPUT_DROP,
+  INPUT_RESET,
+  INPUT_PLAY
+};
+
+// Make the call on game that action stands for, other than
+// INPUT_PLAY.  Returns what the call returned: tick()'s result for
+// INPUT_TICK, 0 for INPUT_RESET, and otherwise 1 if the piece moved.
+int applyInput(Game& game, InputAction action);
+
+// A hash of everything that decides how a game plays on: the occupied
+// cells, the falling piece and where it is, whether the game is over
+// and the pieces previewed next.  Two games that hash alike will go on
+// alike under the same inputs.
+uint64_t hashGameState(const Game& game);
+
+// Writes an input log.  The log starts with the well size and the
+// piece source's seed, mode and lookahead, then holds the calls made,
+// each run of the same call as one varint, and ends with the hash of
+// the final state.  A game of a few thousand pieces comes to a few
+// kilobytes.  Placements store x in 16 bits, so logs of wells wider
+// than INT16_MAX columns do not replay.
+//
+// Start the recorder on a game straight after constructing it, then
+// tell it about every call made on the game, after making it.
+class InputRecorder
+{
+public:
+  explicit InputRecorder(const Game& game);
+
+  void record(InputAction action);
+  void recordPlay(const Placement& p);
+
+  // Close the log with game's final state.  Nothing more may be
+  // recorded afterwards.
+  const std::vector<unsigned char>& finish(const Game& game);
+
+  const std::vector<unsigned char>& getBytes() const
+  {
+    return bytes_;
+  }
+
+private:
+  void flushRun();
+  void putVarint(uint64_t value);
+
+  std::vector<unsigned char> bytes_;
+  int run_action_;
+  uint64_t run_length_;
+};
+
+// What playing back a log found.
+struct ReplayResult {
+  int width;
+  int height;
+  long inputs;
+  long ticks;
+  long lines;
+  uint64_t hash;
+  uint64_t expected_hash;
+};
+
+// Play the log in data back on a new game and fill in result.  Returns
+// false if the log is malformed or truncated; otherwise the replay
+// matched the recording if result.hash == result.expected_hash.
+bool replayInputLog(const unsigned char* data, size_t size,
+                    ReplayResult& result);
+
+#endif // INPUTLOG_H
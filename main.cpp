@@ -7,11 +7,32 @@
 
 #include "window.h"
 #include <QApplication>
+#include <QSurfaceFormat>
 
 int main(int argc, char *argv[])
 {
+    // a 4.2 core profile context, swapping buffers once per display
+    // refresh, which paces the spin
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setVersion(4, 2);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setSwapInterval(1);
+    QSurfaceFormat::setDefaultFormat(format);
+
     QApplication a(argc, argv);
     Window w;
+
+    // --record <file> saves the session's inputs for tetris-replay
+    QStringList args = a.arguments();
+    int record = args.indexOf("--record");
+    if (record > 0 && record + 1 < args.size())
+        w.recordTo(args.at(record + 1));
+
+    // --timings <file> saves render pass timings as CSV on exit
+    int timings = args.indexOf("--timings");
+    if (timings > 0 && timings + 1 < args.size())
+        w.timingsTo(args.at(timings + 1));
+
     w.show();
 
     return a.exec();
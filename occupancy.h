@@ -0,0 +1,128 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Occupancy - the row word operations Game and BasicGame both play by:
+ * where a piece's row mask lands in a row of words, the collision
+ * test, and the skyline arithmetic for drops and line clears.  Each
+ * engine keeps only what its board layout needs on top of these.
+ */
+
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <algorithm>
+
+#include "game.h"
+
+namespace Occupancy {
+
+// Where a 4-bit row mask, placed with its first column at x, falls in
+// a row of words: lo in word w, and hi in word w+1 when the mask
+// straddles a word boundary.  Bits that would land left of column 0
+// are dropped; they are never on, since pieceFits checks the margins
+// first.  A well one word wide can never straddle, so a caller that
+// knows as much passes may_straddle false and loses the test.
+struct RowSpan {
+  int w;
+  RowWord lo;
+  RowWord hi;
+};
+
+inline RowSpan rowSpan(int x, unsigned bits, bool may_straddle = true)
+{
+  if(x < 0) {
+    bits >>= -x;
+    x = 0;
+  }
+
+  int b = x & 63;
+  RowSpan s;
+  s.w = x >> 6;
+  s.lo = RowWord(bits) << b;
+  s.hi = may_straddle && b > 60 ? RowWord(bits) >> (64 - b) : 0;
+  return s;
+}
+
+// Does the mask, as rowSpan places it, touch any occupied cell of the
+// row?
+inline bool rowOverlaps(const RowWord* row, int x, unsigned bits,
+                        bool may_straddle = true)
+{
+  RowSpan s = rowSpan(x, bits, may_straddle);
+  return (row[s.w] & s.lo) || (s.hi && (row[s.w+1] & s.hi));
+}
+
+// Set (or clear) the cells of the row the span covers.
+inline void markRowSpan(RowWord* row, const RowSpan& s, bool on)
+{
+  if(on) {
+    row[s.w] |= s.lo;
+    if(s.hi) {
+      row[s.w+1] |= s.hi;
+    }
+  } else {
+    row[s.w] &= ~s.lo;
+    if(s.hi) {
+      row[s.w+1] &= ~s.hi;
+    }
+  }
+}
+
+// The collision test, against whatever occupancy plane rowAt(r)
+// returns the words of row r from.
+template <typename RowAt>
+inline bool pieceFits(const Piece& p, int x, int y, int width, RowAt rowAt,
+                      bool may_straddle = true)
+{
+  if(x + p.getLeftMargin() < 0) {
+    return false;
+  }
+
+  if(x + 3 - p.getRightMargin() >= width) {
+    return false;
+  }
+
+  if(y + p.getBottomMargin() < 3) {
+    return false;
+  }
+
+  for(int r = 0; r < 4; ++r) {
+    unsigned bits = p.getRowBits(r);
+    if(bits && rowOverlaps(rowAt(y-r), x, bits, may_straddle)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// The row p would come to rest on at column x if it fell from above
+// the stack, read off the column heights under it.
+inline int landingRow(const Piece& p, int x, const int* heights)
+{
+  int y = 0;
+  for(int c = 0; c < 4; ++c) {
+    int bottom = p.getColumnBottom(c);
+    if(bottom >= 0) {
+      y = std::max(y, heights[x+c] + bottom);
+    }
+  }
+  return y;
+}
+
+// A column h high once the rows in cleared, num_cleared of them in
+// rising order, are gone.  Its top cell may have been cleared itself,
+// so the caller still walks down to the next occupied one.
+inline int heightAfterClear(int h, const int* cleared, int num_cleared)
+{
+  int dropped = h;
+  for(int i = 0; i < num_cleared; ++i) {
+    dropped -= cleared[i] < h;
+  }
+  return dropped;
+}
+
+} // namespace Occupancy
+
+#endif // OCCUPANCY_H
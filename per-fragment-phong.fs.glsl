@@ -1,9 +1,10 @@
+#version 410 core
+
 //
 // CPSC 453 - Introduction to Computer Graphics
 // Assignment 1
 //
 // Fragment shader for phong illumination
-// Note: This file should not need to be modified.
 //
 
 // Input from vertex shader
@@ -15,6 +16,9 @@ in VS_OUT
     vec3 C;
 } fs_in;
 
+// Output colour
+out vec4 frag_colour;
+
 // Material properties
 uniform vec3 diffuse_albedo = vec3(0.5, 0.2, 0.7);
 uniform vec3 specular_albedo = vec3(0.7);
@@ -37,5 +41,5 @@ void main(void)
     vec3 specular = pow(max(dot(R, V), 0.0), specular_power) * specular_albedo;
 
     // Write final color to the framebuffer
-    gl_FragColor = vec4(ambient + diffuse + specular, 1.0);
+    frag_colour = vec4(ambient + diffuse + specular, 1.0);
 }
@@ -5,7 +5,6 @@
 // Assignment 1
 //
 // Vertex shader for phong illumination
-// Note: This file should not need to be modified.
 //
 
 // Per-vertex inputs
@@ -13,11 +12,21 @@ layout (location = 0) in vec4 position_attr;
 layout (location = 1) in vec3 colour_attr;
 layout (location = 2) in vec3 normal_attr;
 
+// Per-instance input for cubes: the cell's position and colour index
+layout (location = 3) in vec4 cell_attr;
+
 // Matrices we'll need
 uniform highp mat4 model_matrix;
 uniform highp mat4 view_matrix;
 uniform highp mat4 proj_matrix;
 
+// Where the colour comes from: 0 = colour_attr, 1 = the cell's colour,
+// 2 = a colour per face, shifted by the cell's colour, 3 = black.
+// Vertices with a negative colour index always use colour_attr.
+uniform int colour_mode = 0;
+uniform vec3 cell_colours[10];
+uniform vec3 face_colours[7];
+
 // Inputs from vertex shader
 out VS_OUT
 {
@@ -30,13 +39,25 @@ out VS_OUT
 // Position of light
 uniform vec3 light_pos = vec3(100.0, 100.0, 100.0);
 
+// Which face of a cube a normal belongs to, in the order they are
+// listed: top, back, left, front, right, bottom
+int faceOf(vec3 n)
+{
+    if (n.y > 0.5) return 0;
+    if (n.z < -0.5) return 1;
+    if (n.x < -0.5) return 2;
+    if (n.z > 0.5) return 3;
+    if (n.x > 0.5) return 4;
+    return 5;
+}
+
 void main(void)
 {
     // Calculate model-view matrix
     mat4 mv_matrix = view_matrix * model_matrix;
 
-    // Calculate view-space coordinate
-    vec4 P = mv_matrix * position_attr;
+    // Calculate view-space coordinate, moving cubes to their cell
+    vec4 P = mv_matrix * (position_attr + vec4(cell_attr.xyz, 0.0));
 
     // Calculate normal in view-space
     vs_out.N = mat3(mv_matrix) * normal_attr;
@@ -47,8 +68,16 @@ void main(void)
     // Calculate view vector
     vs_out.V = -P.xyz;
 
-    // Store the colour attribute
-    vs_out.C = colour_attr;
+    // Store the colour
+    int cell_colour = int(cell_attr.w);
+    if (colour_mode == 0 || cell_colour < 0)
+        vs_out.C = colour_attr;
+    else if (colour_mode == 1)
+        vs_out.C = cell_colours[cell_colour];
+    else if (colour_mode == 2)
+        vs_out.C = face_colours[(faceOf(normal_attr) + cell_colour) % 7];
+    else
+        vs_out.C = vec3(0.0);
 
     // Calculate the clip-space position of each vertex
     gl_Position = proj_matrix * P;
@@ -0,0 +1,92 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * PieceSource - a seeded stream of piece kinds for one game.
+ */
+
+#include <algorithm>
+
+#include "piecesource.h"
+
+namespace {
+
+uint64_t splitmix64(uint64_t& x)
+{
+  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+} // namespace
+
+PieceSource::PieceSource(uint64_t seed, Mode mode, int lookahead)
+  : mode_(mode)
+  , lookahead_(std::min(std::max(lookahead, 1), int(MAX_LOOKAHEAD)))
+{
+  reseed(seed);
+}
+
+void PieceSource::reseed(uint64_t seed)
+{
+  seed_ = seed;
+  for(int i = 0; i < 4; ++i) {
+    state_[i] = splitmix64(seed);
+  }
+
+  bag_left_ = 0;
+  head_ = 0;
+  for(int i = 0; i < lookahead_; ++i) {
+    queue_[i] = draw();
+  }
+}
+
+int PieceSource::next()
+{
+  int kind = queue_[head_];
+  queue_[ (head_ + lookahead_) % MAX_LOOKAHEAD ] = draw();
+  head_ = (head_ + 1) % MAX_LOOKAHEAD;
+  return kind;
+}
+
+uint64_t PieceSource::random()
+{
+  uint64_t result = rotl(state_[1] * 5, 7) * 9;
+  uint64_t t = state_[1] << 17;
+
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+  state_[2] ^= t;
+  state_[3] = rotl(state_[3], 45);
+
+  return result;
+}
+
+int PieceSource::draw()
+{
+  // Scale the top 32 bits into [0,n) by multiplying rather than
+  // dividing.
+  if(mode_ == UNIFORM) {
+    return int(((random() >> 32) * 7) >> 32);
+  }
+
+  if(bag_left_ == 0) {
+    for(int i = 0; i < 7; ++i) {
+      bag_[i] = i;
+    }
+    for(int i = 6; i > 0; --i) {
+      int j = int(((random() >> 32) * uint64_t(i + 1)) >> 32);
+      std::swap(bag_[i], bag_[j]);
+    }
+    bag_left_ = 7;
+  }
+  return bag_[ --bag_left_ ];
+}
@@ -0,0 +1,72 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * PieceSource - a seeded stream of piece kinds for one game, so games
+ * on different threads do not share any state and a seed replays the
+ * same sequence every time.
+ */
+
+#ifndef PIECESOURCE_H
+#define PIECESOURCE_H
+
+#include <cstdint>
+
+class PieceSource
+{
+public:
+  // UNIFORM draws each piece independently.  BAG deals the seven
+  // pieces in a shuffled order, then reshuffles.
+  enum Mode {UNIFORM, BAG};
+
+  // Most pieces that can be previewed ahead of the current one.
+  static const int MAX_LOOKAHEAD = 16;
+
+  explicit PieceSource(uint64_t seed = 0, Mode mode = UNIFORM,
+                       int lookahead = 1);
+
+  // Restart the stream from a new seed, keeping mode and lookahead.
+  void reseed(uint64_t seed);
+
+  // Take the next piece kind, in [0,7).
+  int next();
+
+  // The i-th piece kind that next() will return after this one,
+  // starting at 0 for the very next.  i must be below getLookahead().
+  int peek(int i) const
+  {
+    return queue_[ (head_ + i) % MAX_LOOKAHEAD ];
+  }
+
+  int getLookahead() const
+  {
+    return lookahead_;
+  }
+  uint64_t getSeed() const
+  {
+    return seed_;
+  }
+  Mode getMode() const
+  {
+    return mode_;
+  }
+
+private:
+  uint64_t random();
+  int draw();
+
+  // xoshiro256** state, expanded from the seed with splitmix64.
+  uint64_t state_[4];
+  uint64_t seed_;
+  Mode mode_;
+
+  unsigned char bag_[7];
+  int bag_left_;
+
+  // Ring of upcoming pieces, lookahead_ long, starting at head_.
+  unsigned char queue_[MAX_LOOKAHEAD];
+  int head_;
+  int lookahead_;
+};
+
+#endif // PIECESOURCE_H
@@ -0,0 +1,211 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * RecordFile - writing and mapping files of game states.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "recordfile.h"
+
+namespace {
+
+const unsigned char MAGIC[4] = { 'T', 'R', 'E', 'C' };
+
+// Records are written and read as they lie in memory, so both ends
+// must be little-endian.
+bool littleEndian()
+{
+  uint16_t one = 1;
+  unsigned char first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+template <typename T>
+void store(unsigned char* at, T value)
+{
+  std::memcpy(at, &value, sizeof(T));
+}
+
+template <typename T>
+T load(const unsigned char* at)
+{
+  T value;
+  std::memcpy(&value, at, sizeof(T));
+  return value;
+}
+
+} // namespace
+
+RecordWriter::RecordWriter()
+  : file_(nullptr)
+  , width_(0)
+  , height_(0)
+  , buffer_(nullptr)
+  , ok_(false)
+{
+}
+
+RecordWriter::~RecordWriter()
+{
+  close();
+}
+
+bool RecordWriter::open(const char* path, int width, int height)
+{
+  close();
+  if(!littleEndian() || width < 1 || width > RecordFormat::MAX_WIDTH
+     || height < 1 || height > RecordFormat::MAX_HEIGHT) {
+    return false;
+  }
+
+  file_ = std::fopen(path, "wb");
+  if(!file_) {
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  buffer_ = new unsigned char[ RecordFormat::stride(width, height) ];
+
+  unsigned char header[RecordFormat::HEADER_BYTES] = {};
+  std::memcpy(header, MAGIC, sizeof(MAGIC));
+  store<uint32_t>(header + 4, RecordFormat::VERSION);
+  store<uint32_t>(header + 8, uint32_t(width));
+  store<uint32_t>(header + 12, uint32_t(height));
+  store<uint64_t>(header + 16, RecordFormat::stride(width, height));
+  ok_ = std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+  return ok_;
+}
+
+bool RecordWriter::write(const Game& game, int64_t score)
+{
+  if(!file_ || game.getWidth() != width_ || game.getHeight() != height_) {
+    return false;
+  }
+
+  size_t stride = RecordFormat::stride(width_, height_);
+  std::fill(buffer_, buffer_ + stride, 0);
+
+  const PieceSource& pieces = game.getPieceSource();
+  store<uint64_t>(buffer_, pieces.getSeed());
+  store<int64_t>(buffer_ + 8, score);
+  store<int32_t>(buffer_ + 16, game.getPieceY());
+  store<int16_t>(buffer_ + 20, int16_t(game.getPieceX()));
+  buffer_[22] = static_cast<unsigned char>(game.getPiece().getColourIndex());
+  buffer_[23] = static_cast<unsigned char>(game.getPiece().getRotation());
+  buffer_[24] = game.isStopped() ? 1 : 0;
+  buffer_[25] = static_cast<unsigned char>(pieces.peek(0));
+
+  size_t row_bytes = RecordFormat::rowBytes(width_);
+  for(int r = 0; r < height_ + 4; ++r) {
+    unsigned char* row = buffer_ + RecordFormat::FIELD_BYTES + r * row_bytes;
+    for(int c = 0; c < width_; ++c) {
+      row[c >> 1] |= static_cast<unsigned char>((game.get(r, c) + 1) << ((c & 1) * 4));
+    }
+  }
+
+  if(std::fwrite(buffer_, 1, stride, file_) != stride) {
+    ok_ = false;
+  }
+  return ok_;
+}
+
+bool RecordWriter::close()
+{
+  if(!file_) {
+    return false;
+  }
+  if(std::fclose(file_) != 0) {
+    ok_ = false;
+  }
+  file_ = nullptr;
+  delete [] buffer_;
+  buffer_ = nullptr;
+  return ok_;
+}
+
+RecordFile::RecordFile()
+  : map_(nullptr)
+  , map_size_(0)
+  , records_(nullptr)
+  , stride_(0)
+  , count_(0)
+  , width_(0)
+  , height_(0)
+{
+}
+
+RecordFile::~RecordFile()
+{
+  close();
+}
+
+bool RecordFile::open(const char* path)
+{
+  close();
+  if(!littleEndian()) {
+    return false;
+  }
+
+  int fd = ::open(path, O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || size_t(st.st_size) < RecordFormat::HEADER_BYTES) {
+    ::close(fd);
+    return false;
+  }
+  size_t size = size_t(st.st_size);
+  void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(map == MAP_FAILED) {
+    return false;
+  }
+
+  const unsigned char* header = static_cast<const unsigned char*>(map);
+  uint32_t width = load<uint32_t>(header + 8);
+  uint32_t height = load<uint32_t>(header + 12);
+  uint64_t stride = load<uint64_t>(header + 16);
+  if(std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0
+     || load<uint32_t>(header + 4) != RecordFormat::VERSION
+     || width < 1 || width > uint32_t(RecordFormat::MAX_WIDTH)
+     || height < 1 || height > uint32_t(RecordFormat::MAX_HEIGHT)
+     || stride != RecordFormat::stride(int(width), int(height))) {
+    munmap(map, size);
+    return false;
+  }
+
+  // Corpora are mostly streamed from front to back.
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  map_ = map;
+  map_size_ = size;
+  records_ = header + RecordFormat::HEADER_BYTES;
+  stride_ = size_t(stride);
+  count_ = (size - RecordFormat::HEADER_BYTES) / stride_;
+  width_ = int(width);
+  height_ = int(height);
+  return true;
+}
+
+void RecordFile::close()
+{
+  if(map_) {
+    munmap(map_, map_size_);
+  }
+  map_ = nullptr;
+  map_size_ = 0;
+  records_ = nullptr;
+  stride_ = 0;
+  count_ = 0;
+  width_ = 0;
+  height_ = 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * RecordFile - an on-disk array of game states for offline analysis.
+ * Every record in a file has the same size, so a file of millions of
+ * them is read by mapping it into memory and indexing, with nothing
+ * parsed or allocated per record.
+ */
+
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "game.h"
+
+// File layout, all little-endian:
+//
+//   header, HEADER_BYTES long:
+//     magic "TREC", version, well width, well height, record stride
+//   records, stride bytes each:
+//     seed         u64  the piece source's seed
+//     score        i64  whatever score the writer kept
+//     piece y      i32  row of the falling piece's top-left corner
+//     piece x      i16  column of the same
+//     piece        u8   kind of the falling piece, its colour index
+//     rotation     u8
+//     flags        u8   bit 0 set when the game is over
+//     next         u8   kind of the piece after this one
+//     (padding)    6 bytes of zero
+//     cells        a nibble per cell, holding get(r, c) + 1, for the
+//                  (height + 4) rows from the bottom, even columns in
+//                  the low nibble, each row starting on a new byte
+//     (padding)    zeros up to a multiple of 8 bytes
+namespace RecordFormat {
+  const uint32_t VERSION = 1;
+  const size_t HEADER_BYTES = 32;
+  const size_t FIELD_BYTES = 32;
+
+  // The largest well a file can hold.  Piece x is stored in 16 bits.
+  const int MAX_WIDTH = INT16_MAX;
+  const int MAX_HEIGHT = 1 << 20;
+
+  // Bytes per row of cells and per record, for a well of the given
+  // size.
+  inline size_t rowBytes(int width)
+  {
+    return (size_t(width) + 1) / 2;
+  }
+  inline size_t stride(int width, int height)
+  {
+    return (FIELD_BYTES + rowBytes(width) * (height + 4) + 7) & ~size_t(7);
+  }
+}
+
+// A view of one record, pointing into a mapped file.  Reading a field
+// loads just that field.
+class GameRecord
+{
+public:
+  GameRecord(const unsigned char* data, int width, int height)
+    : data_(data)
+    , width_(width)
+    , height_(height)
+  {}
+
+  uint64_t getSeed() const
+  {
+    return load<uint64_t>(0);
+  }
+  int64_t getScore() const
+  {
+    return load<int64_t>(8);
+  }
+  int getPieceY() const
+  {
+    return load<int32_t>(16);
+  }
+  int getPieceX() const
+  {
+    return load<int16_t>(20);
+  }
+  Piece getPiece() const
+  {
+    return Piece(data_[22], data_[23]);
+  }
+  bool isStopped() const
+  {
+    return data_[24] & 1;
+  }
+  int getNextPiece() const
+  {
+    return data_[25];
+  }
+
+  int getWidth() const
+  {
+    return width_;
+  }
+  int getHeight() const
+  {
+    return height_;
+  }
+
+  // The cell at row r and column c, as Game::get() returned it.
+  int get(int r, int c) const
+  {
+    unsigned char b = data_[RecordFormat::FIELD_BYTES
+                            + size_t(r) * RecordFormat::rowBytes(width_)
+                            + (c >> 1)];
+    return ((b >> ((c & 1) * 4)) & 0xf) - 1;
+  }
+
+  // Row r's cells, packed as described above, for callers that want
+  // to work on bytes.
+  const unsigned char* getRowBytes(int r) const
+  {
+    return data_ + RecordFormat::FIELD_BYTES
+      + size_t(r) * RecordFormat::rowBytes(width_);
+  }
+
+private:
+  template <typename T> T load(size_t at) const
+  {
+    T value;
+    std::memcpy(&value, data_ + at, sizeof(T));
+    return value;
+  }
+
+  const unsigned char* data_;
+  int width_;
+  int height_;
+};
+
+// Appends game states to a record file.
+class RecordWriter
+{
+public:
+  RecordWriter();
+  ~RecordWriter();
+
+  // Create path, replacing any file there, for records of the given
+  // well size.  Returns false if it cannot be created or the well is
+  // larger than RecordFormat::MAX_WIDTH by MAX_HEIGHT.
+  bool open(const char* path, int width, int height);
+
+  // Write game's state with the given score.  game must have the
+  // well size the file was opened for.  Returns false on a write
+  // error, after which the file is incomplete.
+  bool write(const Game& game, int64_t score);
+
+  // Flush and close the file.  Returns false if anything failed to
+  // reach it.
+  bool close();
+
+private:
+  RecordWriter(const RecordWriter&);
+  RecordWriter& operator =(const RecordWriter&);
+
+  std::FILE* file_;
+  int width_;
+  int height_;
+  unsigned char* buffer_;
+  bool ok_;
+};
+
+// A record file mapped read-only into memory.
+class RecordFile
+{
+public:
+  RecordFile();
+  ~RecordFile();
+
+  // Map path.  Returns false, leaving the object closed, if it cannot
+  // be mapped or is not a record file of this version.  A partly
+  // written last record is left out.
+  bool open(const char* path);
+  void close();
+
+  int getWidth() const
+  {
+    return width_;
+  }
+  int getHeight() const
+  {
+    return height_;
+  }
+  size_t size() const
+  {
+    return count_;
+  }
+
+  GameRecord operator [](size_t i) const
+  {
+    return GameRecord(records_ + i * stride_, width_, height_);
+  }
+
+private:
+  RecordFile(const RecordFile&);
+  RecordFile& operator =(const RecordFile&);
+
+  void* map_;
+  size_t map_size_;
+  const unsigned char* records_;
+  size_t stride_;
+  size_t count_;
+  int width_;
+  int height_;
+};
+
+#endif // RECORDFILE_H
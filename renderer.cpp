@@ -1,11 +1,9 @@
 #include "renderer.h"
 #include <QTextStream>
 #include <QOpenGLBuffer>
+#include <QFile>
 #include <cmath>
 
-#define FPS             60.0
-#define TIME_PER_FRAME  1.0/FPS
-
 // color indexes
 #define GRAY_IDX  7
 #define BLACK_IDX 8
@@ -19,11 +17,20 @@ Renderer::Renderer(QWidget *parent)
     scale = 1;
     isScaling = false;
     mouseButtons = false;
-
-    // timer for calling renderer update function
-    renderTimer = new QTimer(this);
-    connect(renderTimer, SIGNAL(timeout()), this, SLOT(update()));
-    renderTimer->start(TIME_PER_FRAME);
+    drawCalls = 0;
+    wellWidth = 0;
+    wellHeight = 0;
+    wellFaceIndices = 0;
+    wellEdgeIndices = 0;
+    frames = 0;
+    timerFrame = 0;
+    gpuTiming = false;
+    for (int i = 0; i < TIMER_FRAMES; i++)
+        timerPending[i] = false;
+
+    // repaints happen when asked for; while the view is moving, each
+    // swapped frame asks for the next, so spinning runs at the vsync rate
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(nextFrame()));
 }
 
 // constructor
@@ -53,21 +60,33 @@ void Renderer::initializeGL()
     m_posAttr = m_program->attributeLocation("position_attr");
     m_colAttr = m_program->attributeLocation("colour_attr");
     m_norAttr = m_program->attributeLocation("normal_attr");
+    m_cellAttr = m_program->attributeLocation("cell_attr");
     m_PMatrixUniform = m_program->uniformLocation("proj_matrix");
     m_VMatrixUniform = m_program->uniformLocation("view_matrix");
     m_MMatrixUniform = m_program->uniformLocation("model_matrix");
+    m_colourModeUniform = m_program->uniformLocation("colour_mode");
     m_programID = m_program->programId();
-
-    // add corner triangles to VBO
-    generateBorderTriangles();
+    m_program->bind();
 
     // add unit cube to VBO
     setupBox();
+
+    // the well is baked once its size is known
+    setupWell();
+
+    // timer queries for the passes of the last few frames
+    glGenQueries(TIMER_FRAMES * PASSES, &m_timerQueries[0][0]);
 }
 
 // called by the Qt GUI system, to allow OpenGL drawing commands
 void Renderer::paintGL()
 {
+    frames++;
+    startTimings();
+
+    // move the view on by a frame
+    animate();
+
     // Clear the screen buffers
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -101,13 +120,24 @@ void Renderer::paintGL()
     transform.scale(scale);
     transform.translate(offset);
 
-    // draw the game board + walls + border triangles
-    drawWalls(&transform);
-    drawGame(&transform);
-    drawTriangles(&transform);
+    // every cube is drawn in the same frame of reference
+    glUniformMatrix4fv(m_MMatrixUniform, 1, false, transform.data());
+    drawCalls = 0;
+
+    // draw the walls + border triangles, then the game board
+    beginPass(WELL_PASS);
+    drawWell();
+    endPass(WELL_PASS);
+
+    beginPass(BOARD_PASS);
+    cellInstances.clear();
+    addGame();
+    drawBoxes();
+    endPass(BOARD_PASS);
 
     // deactivate the program
     m_program->release();
+    finishTimings();
 }
 
 // called by the Qt GUI system, to allow OpenGL to respond to widget resizing
@@ -129,81 +159,6 @@ void Renderer::resizeGL(int w, int h)
     glViewport(0, 0, width(), height());
 }
 
-// add vertices to rectangle list
-const float tri_vertList [] = {
-    0.0, 0.0, 0.0,  // bottom left triangle
-    1.0, 0.0, 0.0,
-    0.0, 1.0, 0.0,
-
-    9.0, 0.0, 0.0,  // bottom right triangle
-    10.0, 0.0, 0.0,
-    10.0, 1.0, 0.0,
-
-    0.0, 19.0, 0.0, // top left triangle
-    1.0, 20.0, 0.0,
-    0.0, 20.0, 0.0,
-
-    10.0, 19.0, 0.0,    // top right triangle
-    10.0, 20.0, 0.0,
-    9.0, 20.0, 0.0 };
-
-float tri_colourList [] = {
-    1, 0, 0,
-    1, 0, 0,    // all red verts
-    1, 0, 0,
-
-    1, 0, 0,
-    1, 0, 0,
-    1, 0, 0,
-
-    1, 0, 0,
-    1, 0, 0,
-    1, 0, 0,
-
-    1, 0, 0,
-    1, 0, 0,
-    1, 0, 0,
-};
-
-float tri_normalList [] = {
-    0.0f, 0.0f, 1.0f,    // facing viewer
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-    0.0f, 0.0f, 1.0f,
-};
-
-// computes the vertices and corresponding colours-per-vertex for a quadrilateral
-// drawn from (x1, y1) to (x2, y2)
-// Note: the magic numbers in the vector insert commands should be better documented
-void Renderer::generateBorderTriangles()
-{
-    long cBufferSize = sizeof(tri_colourList) * sizeof(float);
-    long vBufferSize = sizeof(tri_vertList) * sizeof(float);
-    long nBufferSize = sizeof(tri_normalList) * sizeof(float);
-
-    glGenBuffers(1, &this->m_triVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this->m_triVbo);
-
-    // Allocate buffer
-    glBufferData(GL_ARRAY_BUFFER, vBufferSize + cBufferSize + nBufferSize, NULL, GL_STATIC_DRAW);
-
-    // Upload the data to the GPU
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vBufferSize, &tri_vertList[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize, cBufferSize, &tri_colourList[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize + cBufferSize, nBufferSize, &tri_normalList[0]);
-}
-
 
 // override mouse press event
 void Renderer::mousePressEvent(QMouseEvent * event)
@@ -219,6 +174,9 @@ void Renderer::mousePressEvent(QMouseEvent * event)
 
     // save buttons
     mouseButtons = event->buttons();
+
+    // follow the mouse from the next frame on
+    update();
 }
 
 // override mouse release event
@@ -245,37 +203,7 @@ void Renderer::resetView()
     scale = 1;
     rotation = QVector3D(0, 0, 0);
     rotationVel = QVector3D(0, 0, 0);
-}
-
-// helper function, draw corner triangles
-void Renderer::drawTriangles(QMatrix4x4 * transform)
-{
-    QMatrix4x4 model_matrix = *transform;
-    glUniformMatrix4fv(m_MMatrixUniform, 1, false, model_matrix.data());
-
-    long cBufferSize = sizeof(tri_colourList) * sizeof(float);
-    long vBufferSize = sizeof(tri_vertList) * sizeof(float);
-    long nBufferSize = sizeof(tri_normalList) * sizeof(float);
-
-    // Bind to the correct context
-    glBindBuffer(GL_ARRAY_BUFFER, this->m_triVbo);
-
-    // Enable the attribute arrays
-    glEnableVertexAttribArray(this->m_posAttr);
-    glEnableVertexAttribArray(this->m_colAttr);
-    glEnableVertexAttribArray(this->m_norAttr);
-
-    // Specifiy where these are in the VBO
-    glVertexAttribPointer(this->m_posAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)0);
-    glVertexAttribPointer(this->m_colAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)(vBufferSize));
-    glVertexAttribPointer(this->m_norAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)(vBufferSize + cBufferSize));
-
-    // Draw the triangles
-    glDrawArrays(GL_TRIANGLES, 0, 12); // 12 vertices
-
-    glDisableVertexAttribArray(m_norAttr);
-    glDisableVertexAttribArray(m_colAttr);
-    glDisableVertexAttribArray(m_posAttr);
+    update();
 }
 
 // public set method for game
@@ -284,77 +212,47 @@ void Renderer::setGame(Game *game)
     this->game = game;
 }
 
+// public get method for the draw calls made by the last frame
+int Renderer::getDrawCalls() const
+{
+    return drawCalls;
+}
+
 // public set method for isScaling flag
 void Renderer::setIsScaling(bool val)
 {
     this->isScaling = val;
 }
 
-// draws all cubes for the "well"
-void Renderer::drawWalls(QMatrix4x4 * transform)
+// queues a cube at (x, y) with colour index cIdx
+void Renderer::addBox(int x, int y, int cIdx)
 {
-    int width = game->getWidth();
-    int height = game->getHeight();
-
-    int i = 0;
-    // draw the well sides
-    for (i = -1; i < height; i++)
-    {
-        QMatrix4x4 model_matrix = *transform;       // copy original transform matrix
-
-        // left wall
-        QVector3D cubePos = QVector3D(-1, i, 0.0f);
-        model_matrix.translate(cubePos);            // transform * translate
-        glUniformMatrix4fv(m_MMatrixUniform, 1, false, model_matrix.data());
-        drawBox(GRAY_IDX);
-
-        // right wall
-        cubePos = QVector3D(width, i, 0.0f);
-        model_matrix = *transform;                  // copy original transform matrix
-        model_matrix.translate(cubePos);
-        glUniformMatrix4fv(m_MMatrixUniform, 1, false, model_matrix.data());
-        drawBox(GRAY_IDX);
-    }
-
-    // draw the well bottom
-    for (i = 0; i < width ; i++)
-    {
-        QMatrix4x4 model_matrix(*transform);
-
-        QVector3D cubePos = QVector3D(i, -1, 0.0f);
-        model_matrix.translate(cubePos);
-        glUniformMatrix4fv(m_MMatrixUniform, 1, false, model_matrix.data());
-        drawBox(GRAY_IDX);
-    }
+    cellInstances.push_back(x);
+    cellInstances.push_back(y);
+    cellInstances.push_back(0.0f);
+    cellInstances.push_back(cIdx);
 }
 
-void Renderer::drawGame(QMatrix4x4 * transform)
+// queues a cube for each block on the game board
+void Renderer::addGame()
 {
     int width = game->getWidth();
     int height = game->getHeight();
 
-    int i = 0;
-    // iterate through the game board and draw each block
-    for (i = 0; i < width * (height + 4); i++)
+    int r, c;
+    for (r = 0; r < height + 4; r++)
     {
-        int r = i / width;
-        int c = i % width;
-        QMatrix4x4 model_matrix(*transform);    // copy original transform matrix
-
-        // check the board position
-        int cell = game->get(r, c);
-
-        // if this board position is empty, skip
-        if (cell == -1)
-            continue;
-
-        QVector3D cubePos = QVector3D(c, r, 0.0f);
+        for (c = 0; c < width; c++)
+        {
+            // check the board position
+            int cell = game->get(r, c);
 
-        // transform * translate
-        model_matrix.translate(cubePos);
-        glUniformMatrix4fv(m_MMatrixUniform, 1, false, model_matrix.data());
+            // if this board position is empty, skip
+            if (cell == -1)
+                continue;
 
-        drawBox(cell);
+            addBox(c, r, cell);
+        }
     }
 }
 
@@ -364,7 +262,7 @@ void Renderer::setDrawMode(DrawMode mode)
     drawMode = mode;
 }
 
-// Define the box's geometry (as quads)
+// Define the box's geometry (4 vertices per face, drawn by index)
 const float box_coords[] = {
     0,1,0,  0,1,1,  1,1,1, 1,1,0,   // top
     0,1,0,  1,1,0,  1,0,0, 0,0,0,   // back
@@ -384,165 +282,315 @@ const float box_norms[] = {
     0,-1,0,  0,-1,0,  0,-1,0,  0,-1,0,  // bottom
 };
 
-// all box colours
+// colours of cells by colour index, one per cube
 const float box_cols[] = {
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,  // red
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,
-    1,0,0,  1,0,0,  1,0,0,  1,0,0,
-
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,  // blue
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,
-    0,0,1,  0,0,1,  0,0,1,  0,0,1,
-
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,  // green
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,
-    0,1,0,  0,1,0,  0,1,0,  0,1,0,
-
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,  // yellow
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,
-    1,1,0,  1,1,0,  1,1,0,  1,1,0,
-
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,  // cyan
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,
-    0,1,1,  0,1,1,  0,1,1,  0,1,1,
-
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,  // magenta
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,
-    1,0,1,  1,0,1,  1,0,1,  1,0,1,
-
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,  // orange
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,
-    1,.5,0,  1,.5,0,  1,.5,0,  1,.5,0,
-
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  // gray
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,
-    .5,.5,.5,  .5,.5,.5,  .5,.5,.5,  .5,.5,.5,
-
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,    // black
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,
-    0,0,0,  0,0,0,  0,0,0,  0,0,0,
+    1,0,0,      // red
+    0,0,1,      // blue
+    0,1,0,      // green
+    1,1,0,      // yellow
+    0,1,1,      // cyan
+    1,0,1,      // magenta
+    1,.5,0,     // orange
+    .5,.5,.5,   // gray
+    0,0,0,      // black
+    0,0,0,      // (multicolour, unused)
 };
 
-// face colours in multicoloured mode, each face a dif colour
+// face colours in multicoloured mode, each face a dif colour, starting
+// at the cube's colour index
 const float box_cols_multi[] = {
-    1,0,0,	1,0,0,	1,0,0,	1,0,0,
-    1,.3,0,	1,.3,0,	1,.3,0,	1,.3,0,
-    1,1,0,	1,1,0,	1,1,0,	1,1,0,
-    0,1,0,	0,1,0,	0,1,0,	0,1,0,
-    0,.3,1,	0,.3,1,	0,.3,1,	0,.3,1,
-    .5,.3,1,	.5,.3,1,	.5,.3,1, 	.5,.3,1,
-    1,0,1,	1,0,1,	1,0,1, 	1,0,1,
-    1,0,0,	1,0,0,	1,0,0,	1,0,0,
-    1,.3,0,	1,.3,0,	1,.3,0,	1,.3,0,
-    1,1,0,	1,1,0,	1,1,0,	1,1,0,
-    0,1,0,	0,1,0,	0,1,0,	0,1,0,
-    0,.3,1,	0,.3,1,	0,.3,1,	0,.3,1,
-    .5,.3,1,	.5,.3,1,	.5,.3,1, 	.5,.3,1,
-    1,0,1,	1,0,1,	1,0,1, 	1,0,1,
+    1,0,0,
+    1,.3,0,
+    1,1,0,
+    0,1,0,
+    0,.3,1,
+    .5,.3,1,
+    1,0,1,
 };
 
-// Saves all the cube info to the VBO
-void Renderer::setupBox()
+// each quad of the box as two triangles
+const GLuint box_faces[] = {
+    0,1,2,     0,2,3,       // top
+    4,5,6,     4,6,7,       // back
+    8,9,10,    8,10,11,     // left
+    12,13,14,  12,14,15,    // front
+    16,17,18,  16,18,19,    // right
+    20,21,22,  20,22,23,    // bottom
+};
+
+// the 12 edges of the box, as vertex pairs
+const GLuint box_edges[] = {
+    0,1,  1,2,  2,3,  3,0,          // around the top
+    20,21,  21,22,  22,23,  23,20,  // around the bottom
+    4,7,  5,6,  12,13,  15,14,      // the uprights
+};
+
+// floats per well vertex: position, colour, normal, cell
+#define WELL_FLOATS 13
+
+// adds a vertex to the well mesh, with the colour index cIdx (-1 to
+// always use the colour)
+static void addWellVertex(vector<GLfloat> &verts, float x, float y, float z,
+                          const float *colour, const float *normal, int cIdx)
 {
-    long cBufferSize = sizeof(box_cols) * sizeof(float);
-    long cBufferSizeMulti = sizeof(box_cols_multi) * sizeof(float);
-    long vBufferSize = sizeof(box_coords) * sizeof(float);
-    long nBufferSize = sizeof(box_norms) * sizeof(float);
+    GLfloat v[WELL_FLOATS] = { x, y, z,
+                               colour[0], colour[1], colour[2],
+                               normal[0], normal[1], normal[2],
+                               0, 0, 0, (GLfloat)cIdx };
+    verts.insert(verts.end(), v, v + WELL_FLOATS);
+}
 
-    glGenBuffers(1, &this->m_boxVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this->m_boxVbo);
+// adds a gray cube at (x, y) to the well mesh, its faces and edges
+static void addWellBox(vector<GLfloat> &verts, vector<GLuint> &faces,
+                       vector<GLuint> &edges, int x, int y)
+{
+    GLuint base = verts.size() / WELL_FLOATS;
+    unsigned int i;
+
+    for (i = 0; i < 24; i++)
+        addWellVertex(verts, x + box_coords[i * 3], y + box_coords[i * 3 + 1],
+                      box_coords[i * 3 + 2], &box_cols[GRAY_IDX * 3],
+                      &box_norms[i * 3], GRAY_IDX);
+    for (i = 0; i < sizeof(box_faces) / sizeof(GLuint); i++)
+        faces.push_back(base + box_faces[i]);
+    for (i = 0; i < sizeof(box_edges) / sizeof(GLuint); i++)
+        edges.push_back(base + box_edges[i]);
+}
 
-    // Allocate buffer
-    glBufferData(GL_ARRAY_BUFFER, vBufferSize + cBufferSize + cBufferSizeMulti + nBufferSize, NULL, GL_STATIC_DRAW);
+// Creates the buffers and attribute layout for the well mesh
+void Renderer::setupWell()
+{
+    GLsizei stride = WELL_FLOATS * sizeof(GLfloat);
 
-    // Upload the data to the GPU
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vBufferSize, &box_coords[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize, cBufferSize, &box_cols[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize + cBufferSize, cBufferSizeMulti, &box_cols_multi[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize + cBufferSize + cBufferSizeMulti, nBufferSize, &box_norms[0]);
+    glGenVertexArrays(1, &this->m_wellVao);
+    glBindVertexArray(this->m_wellVao);
+
+    glGenBuffers(1, &this->m_wellVbo);
+    glGenBuffers(1, &this->m_wellIbo);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_wellVbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_wellIbo);
+
+    // Enable the attribute arrays
+    glEnableVertexAttribArray(this->m_posAttr);
+    glEnableVertexAttribArray(this->m_colAttr);
+    glEnableVertexAttribArray(this->m_norAttr);
+    glEnableVertexAttribArray(this->m_cellAttr);
+
+    // Specifiy where these are in the VBO
+    glVertexAttribPointer(this->m_posAttr, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)0);
+    glVertexAttribPointer(this->m_colAttr, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(3 * sizeof(GLfloat)));
+    glVertexAttribPointer(this->m_norAttr, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(6 * sizeof(GLfloat)));
+    glVertexAttribPointer(this->m_cellAttr, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(9 * sizeof(GLfloat)));
+
+    glBindVertexArray(0);
 }
 
-// Draw a unit cube and use colors stored at position cIdx
-void Renderer::drawBox(int cIdx)
+// Rebuilds the walls + border triangles mesh if the well changed size
+void Renderer::bakeWell()
 {
-    int glDrawMode = 0;
-    int floats = 3; // 3 floats per vert
-    int verts = 4;  // 4 verts per quad
-    int quads = 6;  // 6 quads per box
+    int width = game->getWidth();
+    int height = game->getHeight();
+
+    if (width == wellWidth && height == wellHeight)
+        return;
+
+    vector<GLfloat> verts;
+    vector<GLuint> faces;
+    vector<GLuint> edges;
+
+    // the corner triangles come first, so wireframe can draw them alone
+    const float red[] = { 1, 0, 0 };
+    const float facing[] = { 0, 0, 1 };     // facing viewer
+    float w = width;
+    float h = height;
+    const float tris[] = {
+        0, 0,  1, 0,  0, 1,             // bottom left
+        w - 1, 0,  w, 0,  w, 1,         // bottom right
+        0, h - 1,  1, h,  0, h,         // top left
+        w, h - 1,  w, h,  w - 1, h,     // top right
+    };
+    int i = 0;
+    for (i = 0; i < 12; i++)
+    {
+        addWellVertex(verts, tris[i * 2], tris[i * 2 + 1], 0, red, facing, -1);
+        faces.push_back(i);
+    }
+
+    // the well sides
+    for (i = -1; i < height; i++)
+    {
+        addWellBox(verts, faces, edges, -1, i);         // left wall
+        addWellBox(verts, faces, edges, width, i);      // right wall
+    }
+
+    // the well bottom
+    for (i = 0; i < width ; i++)
+        addWellBox(verts, faces, edges, i, -1);
+
+    // edges go after the faces in the one index buffer
+    wellFaceIndices = faces.size();
+    wellEdgeIndices = edges.size();
+    faces.insert(faces.end(), edges.begin(), edges.end());
+
+    // Upload the data to the GPU; the VAO holds the index buffer
+    // binding but not the vertex buffer's, so bind that explicitly
+    glBindVertexArray(this->m_wellVao);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_wellVbo);
+    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), &verts[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(GLuint), &faces[0], GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    wellWidth = width;
+    wellHeight = height;
+}
+
+// Draws the walls + border triangles with one call (two in wireframe)
+void Renderer::drawWell()
+{
+    bakeWell();
+    glBindVertexArray(this->m_wellVao);
 
-    long cBufferSize = sizeof(box_cols) * sizeof(float);
-    long cBufferSize2 = sizeof(box_cols_multi) * sizeof(float);
-    long vBufferSize = sizeof(box_coords) * sizeof(float);
-    long nBufferSize = sizeof(box_norms) * sizeof(float);
+    switch (drawMode)
+    {
+        case WIRE:     // wireframe
+            glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_INT, (const GLvoid*)0);
+            glUniform1i(m_colourModeUniform, 3);    // draw lines in black
+            glDrawElements(GL_LINES, wellEdgeIndices, GL_UNSIGNED_INT,
+                           (const GLvoid*)(wellFaceIndices * sizeof(GLuint)));
+            drawCalls += 2;
+            break;
+        case FACES:     // regular faces
+        case MULTI:     // multicolor
+            glUniform1i(m_colourModeUniform, drawMode == FACES ? 1 : 2);
+            glDrawElements(GL_TRIANGLES, wellFaceIndices, GL_UNSIGNED_INT, (const GLvoid*)0);
+            drawCalls++;
+            break;
+    }
 
-    long cBufferOffset = 0;
+    glUniform1i(m_colourModeUniform, 0);
+    glBindVertexArray(0);
+}
 
-    // Bind to the correct context
+// Saves all the cube info to the VBO
+void Renderer::setupBox()
+{
+    long vBufferSize = sizeof(box_coords);
+    long nBufferSize = sizeof(box_norms);
+    long fBufferSize = sizeof(box_faces);
+    long eBufferSize = sizeof(box_edges);
+
+    glGenVertexArrays(1, &this->m_boxVao);
+    glBindVertexArray(this->m_boxVao);
+
+    glGenBuffers(1, &this->m_boxVbo);
     glBindBuffer(GL_ARRAY_BUFFER, this->m_boxVbo);
 
+    // Allocate buffer
+    glBufferData(GL_ARRAY_BUFFER, vBufferSize + nBufferSize, NULL, GL_STATIC_DRAW);
+
+    // Upload the data to the GPU
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vBufferSize, &box_coords[0]);
+    glBufferSubData(GL_ARRAY_BUFFER, vBufferSize, nBufferSize, &box_norms[0]);
+
     // Enable the attribute arrays
     glEnableVertexAttribArray(this->m_posAttr);
-    glEnableVertexAttribArray(this->m_colAttr);
     glEnableVertexAttribArray(this->m_norAttr);
 
     // Specifiy where these are in the VBO
     glVertexAttribPointer(this->m_posAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)0);
+    glVertexAttribPointer(this->m_norAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)(vBufferSize));
+
+    // the face triangles, then the edges
+    glGenBuffers(1, &this->m_boxIbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_boxIbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, fBufferSize + eBufferSize, NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, fBufferSize, &box_faces[0]);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, fBufferSize, eBufferSize, &box_edges[0]);
+
+    // the per-cube positions and colours are filled in every frame,
+    // advancing once per cube
+    glGenBuffers(1, &this->m_cellVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_cellVbo);
+    glEnableVertexAttribArray(this->m_cellAttr);
+    glVertexAttribPointer(this->m_cellAttr, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+    glVertexAttribDivisor(this->m_cellAttr, 1);
+
+    glBindVertexArray(0);
+
+    // colours are looked up by the shader
+    glUniform3fv(m_program->uniformLocation("cell_colours"), 10, box_cols);
+    glUniform3fv(m_program->uniformLocation("face_colours"), 7, box_cols_multi);
+}
+
+// Draw every queued cube with one instanced call
+void Renderer::drawBoxes()
+{
+    int glDrawMode = 0;
+    int colourMode = 0;
+    GLsizei indices = 0;
+    long indexOffset = 0;
+    GLsizei count = (GLsizei)(cellInstances.size() / 4);
+
+    if (count == 0)
+        return;
+
+    // Upload this frame's cubes, orphaning last frame's storage
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_cellVbo);
+    glBufferData(GL_ARRAY_BUFFER, cellInstances.size() * sizeof(GLfloat),
+                 &cellInstances[0], GL_STREAM_DRAW);
+
+    glBindVertexArray(this->m_boxVao);
 
     switch (drawMode)
     {
-        case WIRE:     // wireframe
-            cBufferOffset = sizeof(float) * floats * verts * quads * BLACK_IDX; // draw lines in black
-            glDrawMode = GL_LINE_STRIP;
+        case WIRE:     // wireframe, each edge once
+            colourMode = 3; // draw lines in black
+            glDrawMode = GL_LINES;
+            indices = sizeof(box_edges) / sizeof(GLuint);
+            indexOffset = sizeof(box_faces);
             break;
         case FACES:     // regular faces
-            cBufferOffset = sizeof(float) * floats * verts * quads * cIdx;
-            glDrawMode = GL_QUADS;
+            colourMode = 1;
+            glDrawMode = GL_TRIANGLES;
+            indices = sizeof(box_faces) / sizeof(GLuint);
             break;
         case MULTI:     // multicolor
-            cBufferOffset = cBufferSize + sizeof(float) * floats * verts * (quads + cIdx);
-            glDrawMode = GL_QUADS;
+            colourMode = 2;
+            glDrawMode = GL_TRIANGLES;
+            indices = sizeof(box_faces) / sizeof(GLuint);
             break;
     }
-    glVertexAttribPointer(this->m_colAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)(vBufferSize + cBufferOffset));
-    glVertexAttribPointer(this->m_norAttr, 3, GL_FLOAT, 0, GL_FALSE, (const GLvoid*)(vBufferSize + cBufferSize + cBufferSize2));
+    glUniform1i(m_colourModeUniform, colourMode);
 
-    // Draw the faces
-    glDrawArrays(glDrawMode, 0, 24); // 24 vertices
+    // Draw the faces or edges
+    glDrawElementsInstanced(glDrawMode, indices, GL_UNSIGNED_INT, (const GLvoid*)indexOffset, count);
+    drawCalls++;
 
-    glDisableVertexAttribArray(m_norAttr);
-    glDisableVertexAttribArray(m_colAttr);
-    glDisableVertexAttribArray(m_posAttr);
+    glUniform1i(m_colourModeUniform, 0);
+    glBindVertexArray(0);
 }
 
-// updates the continuous spin, and repaints widget
+// repaints the widget once, at the next frame
 void Renderer::update()
+{
+    QOpenGLWidget::update();
+}
+
+// keeps repainting, one frame after another, while the view is moving
+void Renderer::nextFrame()
+{
+    if (mouseButtons != Qt::NoButton || !rotationVel.isNull())
+        QOpenGLWidget::update();
+}
+
+// public get method for the number of frames painted
+long Renderer::getFrameCount() const
+{
+    return frames;
+}
+
+// updates the continuous spin, or the rotation/scale from the mouse
+void Renderer::animate()
 {
     // only spin the model if no buttons are pressed
     if (mouseButtons == Qt::NoButton)
@@ -582,5 +630,118 @@ void Renderer::update()
         }
         prevMousePos = currMousePos;
     }
-    QOpenGLWidget::update();
+}
+
+// pass names, as shown and written out
+const char * Renderer::passName(int pass)
+{
+    switch (pass)
+    {
+        case WELL_PASS:
+            return "well";
+        case BOARD_PASS:
+            return "board";
+    }
+    return "";
+}
+
+// public get methods for the recent times of a pass, in microseconds
+const RollingTimes & Renderer::getCpuTimes(int pass) const
+{
+    return cpuTimes[pass];
+}
+
+const RollingTimes & Renderer::getGpuTimes(int pass) const
+{
+    return gpuTimes[pass];
+}
+
+// Collects the GPU times of the frame that last used this frame's
+// queries, if they are in.  If not, this frame goes untimed on the GPU
+// rather than waiting for them.
+void Renderer::startTimings()
+{
+    timerFrame = (timerFrame + 1) % TIMER_FRAMES;
+    gpuTiming = true;
+    if (!timerPending[timerFrame])
+        return;
+
+    GLint available = 0;
+    glGetQueryObjectiv(m_timerQueries[timerFrame][PASSES - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        gpuTiming = false;
+        return;
+    }
+
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_timerQueries[timerFrame][pass], GL_QUERY_RESULT, &ns);
+        gpuTimes[pass].add(ns / 1000.0);
+    }
+    timerPending[timerFrame] = false;
+}
+
+// Marks this frame's queries as waiting to be read
+void Renderer::finishTimings()
+{
+    if (gpuTiming)
+        timerPending[timerFrame] = true;
+}
+
+// Starts timing a pass on the CPU and GPU
+void Renderer::beginPass(Pass pass)
+{
+    if (gpuTiming)
+        glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[timerFrame][pass]);
+    passStart = std::chrono::steady_clock::now();
+}
+
+// Stops timing a pass
+void Renderer::endPass(Pass pass)
+{
+    std::chrono::duration<double, std::micro> cpu = std::chrono::steady_clock::now() - passStart;
+    cpuTimes[pass].add(cpu.count());
+    if (gpuTiming)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+// Percentiles of each pass's times, a line per pass, for showing
+QString Renderer::getTimingsSummary() const
+{
+    QString text = "us      cpu p50/p95/p99      gpu p50/p95/p99";
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        const RollingTimes & cpu = cpuTimes[pass];
+        const RollingTimes & gpu = gpuTimes[pass];
+        text += QString("\n%1 %2/%3/%4  %5/%6/%7").arg(passName(pass), -5)
+            .arg(cpu.percentile(50), 6, 'f', 0).arg(cpu.percentile(95), 6, 'f', 0)
+            .arg(cpu.percentile(99), 6, 'f', 0).arg(gpu.percentile(50), 6, 'f', 0)
+            .arg(gpu.percentile(95), 6, 'f', 0).arg(gpu.percentile(99), 6, 'f', 0);
+    }
+    text += "\ndraw calls: " + QString::number(drawCalls);
+    return text;
+}
+
+// Writes each pass's percentiles to a CSV file at path
+bool Renderer::writeTimings(const QString & path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "pass,clock,samples,p50_us,p95_us,p99_us\n";
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        const RollingTimes * times[2] = { &cpuTimes[pass], &gpuTimes[pass] };
+        const char * clocks[2] = { "cpu", "gpu" };
+        for (int i = 0; i < 2; i++)
+            out << passName(pass) << "," << clocks[i] << "," << times[i]->size() << ","
+                << times[i]->percentile(50) << "," << times[i]->percentile(95) << ","
+                << times[i]->percentile(99) << "\n";
+    }
+    out.flush();
+    return out.status() == QTextStream::Ok && file.error() == QFile::NoError;
 }
@@ -10,6 +10,7 @@
 
 #define _USE_MATH_DEFINES
 #include "game.h"
+#include "rollingtimes.h"
 #include <QWidget>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_4_2_Core>
@@ -17,7 +18,8 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLShader>
 #include <QMouseEvent>
-#include <QTimer>
+#include <QString>
+#include <chrono>
 
 using namespace std;
 
@@ -37,13 +39,26 @@ public:
     // draw mode types
     enum DrawMode {WIRE, FACES, MULTI};
 
+    // the timed parts of a frame: walls + border triangles, game board
+    enum Pass {WELL_PASS, BOARD_PASS, PASSES};
+
     // public accessors
     void setGame(Game *game);
     void setIsScaling(bool val);
     void setDrawMode(DrawMode mode);
+    int getDrawCalls() const;
+    long getFrameCount() const;
+
+    // recent CPU and GPU times of each pass, and their percentiles as
+    // text or written to a CSV file
+    static const char * passName(int pass);
+    const RollingTimes & getCpuTimes(int pass) const;
+    const RollingTimes & getGpuTimes(int pass) const;
+    QString getTimingsSummary() const;
+    bool writeTimings(const QString & path) const;
 
 public slots:
-    // updates the transformations and calls widget update
+    // repaints the widget; call whenever the game changes
     void update();
 
     // resets the model transformations
@@ -70,43 +85,63 @@ protected:
     // Called when the mouse moves
     virtual void mouseMoveEvent(QMouseEvent * event);
 
+private slots:
+    // asks for another frame if the view is still moving
+    void nextFrame();
+
 private:
     // member variables for shader manipulation
     GLuint m_programID;
     GLuint m_posAttr;
     GLuint m_colAttr;
     GLuint m_norAttr;
+    GLuint m_cellAttr; // per-cube position and colour index
     GLuint m_MMatrixUniform; // model matrix
     GLuint m_VMatrixUniform; // view matrix
     GLuint m_PMatrixUniform; // projection matrix
-
-    // pointer to border triangles vbo
-    GLuint m_triVbo;
-    // pointer to box vbo
+    GLuint m_colourModeUniform;
+
+    // pointer to walls + border triangles vao, vbo and index buffer
+    GLuint m_wellVao;
+    GLuint m_wellVbo;
+    GLuint m_wellIbo;
+    // pointer to box vao, vbo and index buffer
+    GLuint m_boxVao;
     GLuint m_boxVbo;
+    GLuint m_boxIbo;
+    // pointer to per-cube instance vbo
+    GLuint m_cellVbo;
 
     QOpenGLShaderProgram *m_program;
 
-    // for storing triangle vertices and colours
-    vector<GLfloat> triVertices;
-    vector<GLfloat> triColours;
-    vector<GLfloat> triNormals;
+    // well size the walls mesh was baked for
+    int wellWidth;
+    int wellHeight;
+    // indices of the walls + triangles, then of the wall edges
+    GLsizei wellFaceIndices;
+    GLsizei wellEdgeIndices;
+
+    // cubes to draw this frame, as x, y, z, colour index
+    vector<GLfloat> cellInstances;
+    // draw calls made by the last frame
+    int drawCalls;
 
     // helper function for loading shaders
     GLuint loadShader(GLenum type, const char *source);
 
-    // helper functions for drawing/saving corner triangles to VBO
-    void generateBorderTriangles();    
-    void drawTriangles(QMatrix4x4 * transform);
+    // helper functions for baking/drawing the walls + corner triangles
+    void setupWell();
+    void bakeWell();
+    void drawWell();
 
-    // drawing the game walls
-    void drawWalls(QMatrix4x4 * transform);
-    // draw the game board
-    void drawGame(QMatrix4x4 * transform);
+    // queue the game board
+    void addGame();
+    // queue a cube at a cell with specific color index
+    void addBox(int x, int y, int cIdx);
     // initializing a cube
     void setupBox();
-    // draw a cube with specific color index
-    void drawBox(int cIdx);
+    // draw all queued cubes
+    void drawBoxes();
 
     // tetris game reference
     Game *game;
@@ -129,8 +164,29 @@ private:
     // model rotation velocities
     QVector3D rotationVel;
 
-    // timer for calling renderer updates
-    QTimer * renderTimer;
+    // frames painted so far
+    long frames;
+
+    // moves the view on by one frame
+    void animate();
+
+    // GPU timer queries, a set per frame for the last few frames, read
+    // back a few frames late so that nothing waits on them
+    static const int TIMER_FRAMES = 4;
+    GLuint m_timerQueries[TIMER_FRAMES][PASSES];
+    bool timerPending[TIMER_FRAMES];
+    int timerFrame;
+    // whether this frame is being timed on the GPU
+    bool gpuTiming;
+    std::chrono::steady_clock::time_point passStart;
+    RollingTimes cpuTimes[PASSES];
+    RollingTimes gpuTimes[PASSES];
+
+    // helpers for timing a frame and each pass in it
+    void startTimings();
+    void finishTimings();
+    void beginPass(Pass pass);
+    void endPass(Pass pass);
 };
 
 #endif // RENDERER_H
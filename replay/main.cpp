@@ -0,0 +1,104 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * tetris-replay - plays input logs recorded by the game or by
+ * tetris-sim back as fast as the engine runs, and checks that each one
+ * ends in the state it was recorded in.  Exits non-zero if any log is
+ * unreadable or plays out differently, so a corpus of logs can guard
+ * changes to the engine.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "inputlog.h"
+
+namespace {
+
+void usage()
+{
+  std::fprintf(stderr, "usage: tetris-replay [-r repeats] log...\n");
+}
+
+bool readFile(const char* path, std::vector<unsigned char>& bytes)
+{
+  std::FILE* f = std::fopen(path, "rb");
+  if(!f) {
+    return false;
+  }
+  bytes.clear();
+  unsigned char buffer[1 << 16];
+  size_t n;
+  while((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    bytes.insert(bytes.end(), buffer, buffer + n);
+  }
+  bool ok = !std::ferror(f);
+  std::fclose(f);
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  int repeats = 1;
+  int first = 1;
+  if(argc > 2 && std::strcmp(argv[1], "-r") == 0) {
+    repeats = std::atoi(argv[2]);
+    first = 3;
+  }
+  if(first >= argc || repeats < 1) {
+    usage();
+    return 2;
+  }
+
+  int failed = 0;
+  long total_ticks = 0;
+  double total_elapsed = 0;
+  std::vector<unsigned char> bytes;
+
+  for(int i = first; i < argc; ++i) {
+    if(!readFile(argv[i], bytes)) {
+      std::printf("%s: cannot read\n", argv[i]);
+      ++failed;
+      continue;
+    }
+
+    ReplayResult r;
+    bool ok = true;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int k = 0; ok && k < repeats; ++k) {
+      ok = replayInputLog(bytes.data(), bytes.size(), r);
+    }
+    double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+    if(!ok) {
+      std::printf("%s: malformed log\n", argv[i]);
+      ++failed;
+      continue;
+    }
+
+    bool match = r.hash == r.expected_hash;
+    std::printf("%s: %dx%d, %ld inputs, %ld ticks, %ld lines, "
+                "%.0f ticks/sec, %s\n", argv[i], r.width, r.height,
+                r.inputs, r.ticks, r.lines,
+                r.ticks * double(repeats) / elapsed,
+                match ? "ok" : "MISMATCH");
+    if(!match) {
+      ++failed;
+    }
+    total_ticks += r.ticks * repeats;
+    total_elapsed += elapsed;
+  }
+
+  if(argc - first > 1 && total_elapsed > 0) {
+    std::printf("%d logs, %d failed, %.0f ticks/sec\n",
+                argc - first, failed, total_ticks / total_elapsed);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,9 @@
+# tetris-replay: plays recorded input logs back, headless.
+TEMPLATE = app
+TARGET = tetris-replay
+CONFIG += console release
+CONFIG -= qt app_bundle
+
+include(../engine/engine.pri)
+
+SOURCES += main.cpp
@@ -0,0 +1,43 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * RollingTimes - a window of durations and their percentiles.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "rollingtimes.h"
+
+RollingTimes::RollingTimes(size_t window)
+  : window_(std::max(window, size_t(1)))
+  , next_(0)
+{
+  samples_.reserve(window_);
+}
+
+void RollingTimes::add(double us)
+{
+  if(samples_.size() < window_) {
+    samples_.push_back(us);
+  } else {
+    samples_[next_] = us;
+  }
+  next_ = (next_ + 1) % window_;
+}
+
+double RollingTimes::percentile(double p) const
+{
+  if(samples_.empty()) {
+    return 0;
+  }
+
+  // Only the one rank is needed, so partition rather than sort.
+  scratch_ = samples_;
+  size_t n = scratch_.size();
+  size_t rank = size_t(std::ceil(std::min(std::max(p, 0.0), 100.0) / 100 * n));
+  size_t k = rank > 0 ? rank - 1 : 0;
+  std::nth_element(scratch_.begin(), scratch_.begin() + k, scratch_.end());
+  return scratch_[k];
+}
@@ -0,0 +1,40 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * RollingTimes - the most recent durations of something done over and
+ * over, such as a render pass, and percentiles over them.
+ */
+
+#ifndef ROLLINGTIMES_H
+#define ROLLINGTIMES_H
+
+#include <cstddef>
+#include <vector>
+
+class RollingTimes
+{
+public:
+  // Keep the last window samples.
+  explicit RollingTimes(size_t window = 600);
+
+  void add(double us);
+
+  // Samples held, at most the window.
+  size_t size() const
+  {
+    return samples_.size();
+  }
+
+  // The p'th percentile, p in [0, 100], of the samples held, by
+  // nearest rank.  0 if there are none.
+  double percentile(double p) const;
+
+private:
+  std::vector<double> samples_;
+  size_t window_;
+  size_t next_;
+  mutable std::vector<double> scratch_;
+};
+
+#endif // ROLLINGTIMES_H
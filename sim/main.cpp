@@ -0,0 +1,238 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * tetris-sim - plays many games to completion without a GUI, spread
+ * over every core, and reports throughput and line clear statistics.
+ * Each game is driven by a careless player who picks a random column
+ * and rotation for every new piece, steers it there one key press per
+ * tick and drops it.  With -r every game's inputs are also written to
+ * an input log in the given directory, for tetris-replay.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "game.h"
+#include "inputlog.h"
+#include "workpool.h"
+
+namespace {
+
+struct Options {
+  long games;
+  int width;
+  int height;
+  int threads;
+  long max_ticks;
+  uint64_t seed;
+  PieceSource::Mode mode;
+  const char *record_dir;
+};
+
+struct Stats {
+  long games;
+  long ticks;
+  long lines;
+  long clears[5];
+  long unsaved_logs;
+
+  void add(const Stats& other)
+  {
+    games += other.games;
+    ticks += other.ticks;
+    lines += other.lines;
+    unsaved_logs += other.unsaved_logs;
+    for(int i = 0; i < 5; ++i) {
+      clears[i] += other.clears[i];
+    }
+  }
+};
+
+void usage()
+{
+  std::fprintf(stderr,
+               "usage: tetris-sim [-n games] [-w width] [-h height] [-t threads]\n"
+               "                  [-m max-ticks-per-game] [-s seed] [-p uniform|bag]\n"
+               "                  [-r log-directory]\n");
+}
+
+bool parseOptions(int argc, char *argv[], Options& opts)
+{
+  opts.games = 1000;
+  opts.width = 10;
+  opts.height = 20;
+  opts.threads = 0;
+  opts.max_ticks = 1000000;
+  opts.seed = 1;
+  opts.mode = PieceSource::UNIFORM;
+  opts.record_dir = nullptr;
+
+  for(int i = 1; i < argc; ++i) {
+    if(i + 1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2) {
+      return false;
+    }
+    if(argv[i][1] == 'p') {
+      const char *mode = argv[++i];
+      if(std::strcmp(mode, "bag") == 0) {
+        opts.mode = PieceSource::BAG;
+      } else if(std::strcmp(mode, "uniform") != 0) {
+        return false;
+      }
+      continue;
+    }
+    if(argv[i][1] == 'r') {
+      opts.record_dir = argv[++i];
+      continue;
+    }
+
+    long value = std::atol(argv[++i]);
+    switch(argv[i-1][1]) {
+      case 'n': opts.games = value; break;
+      case 'w': opts.width = int(value); break;
+      case 'h': opts.height = int(value); break;
+      case 't': opts.threads = int(value); break;
+      case 'm': opts.max_ticks = value; break;
+      case 's': opts.seed = std::strtoull(argv[i], nullptr, 10); break;
+      default: return false;
+    }
+  }
+
+  return opts.games > 0 && opts.width >= 4 && opts.height >= 1;
+}
+
+// Play one game to the end, recording what happened into stats.  The
+// game's pieces and the player's choices both follow from the seed and
+// the game's index, so a run repeats exactly.
+void playGame(const Options& opts, long index, Stats& stats)
+{
+  Game game(opts.width, opts.height, PieceSource(opts.seed + index, opts.mode));
+  std::mt19937 input(static_cast<unsigned>(opts.seed * 31 + index));
+
+  std::unique_ptr<InputRecorder> log;
+  if(opts.record_dir) {
+    log.reset(new InputRecorder(game));
+  }
+
+  long ticks = 0;
+  int last_y = -1;
+  int target_x = 0;
+  int target_rotation = 0;
+
+  while(ticks < opts.max_ticks) {
+    // A new piece has appeared at the top.
+    if(game.getPieceY() > last_y) {
+      target_x = int(input() % opts.width) - 1;
+      target_rotation = int(input() % 4);
+    }
+
+    InputAction action = INPUT_DROP;
+    if(game.getPiece().getRotation() != target_rotation) {
+      action = INPUT_ROTATE_CW;
+    } else if(game.getPieceX() < target_x) {
+      action = INPUT_RIGHT;
+    } else if(game.getPieceX() > target_x) {
+      action = INPUT_LEFT;
+    }
+    bool steered = false;
+    if(action != INPUT_DROP) {
+      steered = applyInput(game, action) > 0;
+      if(log) {
+        log->record(action);
+      }
+    }
+    if(!steered) {
+      game.drop();
+      if(log) {
+        log->record(INPUT_DROP);
+      }
+    }
+    last_y = game.getPieceY();
+
+    int rm = game.tick();
+    if(log) {
+      log->record(INPUT_TICK);
+    }
+    ++ticks;
+    if(rm < 0) {
+      break;
+    }
+    if(rm > 0) {
+      stats.lines += rm;
+      ++stats.clears[ rm < 4 ? rm : 4 ];
+    }
+  }
+
+  ++stats.games;
+  stats.ticks += ticks;
+
+  if(log) {
+    const std::vector<unsigned char>& bytes = log->finish(game);
+    char path[4096];
+    std::snprintf(path, sizeof(path), "%s/game-%ld.tlog", opts.record_dir, index);
+    std::FILE *f = std::fopen(path, "wb");
+    bool saved = f && std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    if(f && std::fclose(f) != 0) {
+      saved = false;
+    }
+    if(!saved) {
+      ++stats.unsaved_logs;
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  Options opts;
+  if(!parseOptions(argc, argv, opts)) {
+    usage();
+    return 2;
+  }
+
+  WorkPool pool(opts.threads);
+  std::vector<Stats> per_worker(pool.size(), Stats());
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  pool.run(opts.games, [&](long index, int worker) {
+    playGame(opts, index, per_worker[worker]);
+  });
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  Stats total = Stats();
+  for(size_t i = 0; i < per_worker.size(); ++i) {
+    total.add(per_worker[i]);
+  }
+
+  std::printf("well          %dx%d\n", opts.width, opts.height);
+  std::printf("threads       %d\n", pool.size());
+  std::printf("seed          %llu (%s)\n", (unsigned long long)opts.seed,
+              opts.mode == PieceSource::BAG ? "bag" : "uniform");
+  std::printf("games         %ld\n", total.games);
+  std::printf("elapsed       %.3f s\n", elapsed);
+  std::printf("games/sec     %.1f\n", total.games / elapsed);
+  std::printf("ticks/sec     %.0f\n", total.ticks / elapsed);
+  std::printf("ticks/game    %.1f\n", double(total.ticks) / total.games);
+  std::printf("lines         %ld (%.2f/game)\n", total.lines,
+              double(total.lines) / total.games);
+  std::printf("clears        single %ld  double %ld  triple %ld  tetris %ld\n",
+              total.clears[1], total.clears[2], total.clears[3], total.clears[4]);
+  if(opts.record_dir) {
+    std::printf("logs          %ld written to %s\n",
+                total.games - total.unsaved_logs, opts.record_dir);
+  }
+  if(total.unsaved_logs) {
+    std::fprintf(stderr, "tetris-sim: %ld input logs could not be written\n",
+                 total.unsaved_logs);
+    return 1;
+  }
+
+  return 0;
+}
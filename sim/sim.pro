@@ -0,0 +1,9 @@
+# tetris-sim: headless batch simulator.
+TEMPLATE = app
+TARGET = tetris-sim
+CONFIG += console release
+CONFIG -= qt app_bundle
+
+include(../engine/engine.pri)
+
+SOURCES += main.cpp
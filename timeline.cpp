@@ -0,0 +1,129 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Timeline - keyframes and inputs for seeking through a game.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "timeline.h"
+
+namespace {
+
+// Bytes that follow an INPUT_PLAY byte.
+const size_t PLACEMENT_BYTES = sizeof(int16_t) + sizeof(int32_t) + sizeof(uint8_t);
+
+// Make the call stored at inputs[at] on game and return where the
+// next one starts.  Sets ended if the call ended a tick.
+size_t replayInput(const std::vector<unsigned char>& inputs, size_t at,
+                   Game& game, bool& ended)
+{
+  InputAction action = InputAction(inputs[at++]);
+  ended = action == INPUT_TICK || action == INPUT_PLAY;
+  if(action != INPUT_PLAY) {
+    applyInput(game, action);
+    return at;
+  }
+
+  Placement p;
+  std::memcpy(&p.x, &inputs[at], sizeof(p.x));
+  std::memcpy(&p.y, &inputs[at + sizeof(p.x)], sizeof(p.y));
+  p.rotation = inputs[at + sizeof(p.x) + sizeof(p.y)];
+  game.play(p);
+  return at + PLACEMENT_BYTES;
+}
+
+} // namespace
+
+Timeline::Timeline(const Game& game, size_t budget, int interval)
+  : last_tick_(0)
+  , budget_(budget)
+  , interval_(std::max(interval, 1))
+  , bytes_(0)
+{
+  addKeyframe(game);
+}
+
+void Timeline::record(InputAction action, const Game& game)
+{
+  Keyframe& k = keyframes_.back();
+  size_t before = k.inputs.capacity();
+  k.inputs.push_back(static_cast<unsigned char>(action));
+  bytes_ += k.inputs.capacity() - before;
+
+  if(action == INPUT_TICK) {
+    endTick(game);
+  }
+}
+
+void Timeline::recordPlay(const Placement& p, const Game& game)
+{
+  Keyframe& k = keyframes_.back();
+  size_t before = k.inputs.capacity();
+  unsigned char bytes[1 + PLACEMENT_BYTES];
+  bytes[0] = INPUT_PLAY;
+  std::memcpy(bytes + 1, &p.x, sizeof(p.x));
+  std::memcpy(bytes + 1 + sizeof(p.x), &p.y, sizeof(p.y));
+  bytes[1 + sizeof(p.x) + sizeof(p.y)] = p.rotation;
+  k.inputs.insert(k.inputs.end(), bytes, bytes + sizeof(bytes));
+  bytes_ += k.inputs.capacity() - before;
+
+  endTick(game);
+}
+
+bool Timeline::seek(long tick, Game& game) const
+{
+  if(tick < getFirstTick() || tick > last_tick_) {
+    return false;
+  }
+
+  const Keyframe& k = keyframeAt(tick);
+  game = k.game;
+  size_t at = 0;
+  for(long t = k.tick; t < tick; ) {
+    bool ended;
+    at = replayInput(k.inputs, at, game, ended);
+    t += ended;
+  }
+  return true;
+}
+
+void Timeline::endTick(const Game& game)
+{
+  ++last_tick_;
+  if(last_tick_ - keyframes_.back().tick >= interval_) {
+    addKeyframe(game);
+  }
+}
+
+void Timeline::addKeyframe(const Game& game)
+{
+  keyframes_.emplace_back(last_tick_, game);
+  Keyframe& k = keyframes_.back();
+  k.game.setJournaling(false);
+  k.game.clearJournal();
+  k.inputs.reserve(interval_ * 2);
+  bytes_ += keyframeBytes(k);
+
+  while(bytes_ > budget_ && keyframes_.size() > 1) {
+    bytes_ -= keyframeBytes(keyframes_.front());
+    keyframes_.pop_front();
+  }
+}
+
+size_t Timeline::keyframeBytes(const Keyframe& k) const
+{
+  return k.game.getMemoryUsage() + k.inputs.capacity()
+    + sizeof(Keyframe) - sizeof(Game);
+}
+
+// The latest keyframe at or before tick.
+const Timeline::Keyframe& Timeline::keyframeAt(long tick) const
+{
+  std::deque<Keyframe>::const_iterator it = std::upper_bound(
+    keyframes_.begin(), keyframes_.end(), tick,
+    [](long t, const Keyframe& k) { return t < k.tick; });
+  return *(it - 1);
+}
@@ -0,0 +1,85 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * Timeline - the history of one game, kept so that any tick of it can
+ * be brought back: a copy of the game every so many ticks, and the
+ * inputs made in between, which replay deterministically.
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "game.h"
+#include "inputlog.h"
+
+class Timeline
+{
+public:
+  // Start the history of game, as it stands, at tick 0.  A keyframe,
+  // a copy of the game, is kept every interval ticks; seeking replays
+  // at most that many ticks.  Once the history holds more than budget
+  // bytes the oldest keyframes are dropped, along with the inputs
+  // after them, so the earliest reachable tick moves forward.  The
+  // latest keyframe is always kept.
+  explicit Timeline(const Game& game, size_t budget = size_t(32) << 20,
+                    int interval = 256);
+
+  // Tell the timeline about a call made on the game, after making it.
+  // INPUT_TICK and INPUT_PLAY each end a tick.
+  void record(InputAction action, const Game& game);
+  void recordPlay(const Placement& p, const Game& game);
+
+  // The range of ticks that can be sought to.
+  long getFirstTick() const
+  {
+    return keyframes_.front().tick;
+  }
+  long getLastTick() const
+  {
+    return last_tick_;
+  }
+
+  // Set game to the state just after the given tick ended, before any
+  // input that followed it.  Returns false, leaving game alone, if the
+  // tick is outside [getFirstTick(), getLastTick()].
+  bool seek(long tick, Game& game) const;
+
+  // Bytes of history held: the keyframes and the inputs.
+  size_t getMemoryUsage() const
+  {
+    return bytes_;
+  }
+
+private:
+  // A copy of the game as it was when tick ended, and every input
+  // made from then until the next keyframe, one byte each, with a
+  // played placement's fields following its byte.
+  struct Keyframe {
+    long tick;
+    Game game;
+    std::vector<unsigned char> inputs;
+
+    Keyframe(long t, const Game& g)
+      : tick(t)
+      , game(g)
+    {}
+  };
+
+  void endTick(const Game& game);
+  void addKeyframe(const Game& game);
+  size_t keyframeBytes(const Keyframe& k) const;
+  const Keyframe& keyframeAt(long tick) const;
+
+  std::deque<Keyframe> keyframes_;
+  long last_tick_;
+  size_t budget_;
+  int interval_;
+  size_t bytes_;
+};
+
+#endif // TIMELINE_H
@@ -0,0 +1,114 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * TranspositionTable - a lock-free table of scores keyed by board
+ * hash.
+ */
+
+#include <cstring>
+
+#include "transtable.h"
+
+namespace {
+
+// What an empty slot holds as its check word: matches no key but ~0.
+const uint64_t EMPTY_CHECK = ~uint64_t(0);
+
+// Counts are only ever statistics, so nothing needs ordering.
+const std::memory_order RELAXED = std::memory_order_relaxed;
+
+} // namespace
+
+TranspositionTable::TranspositionTable(int log2_entries)
+  : mask_((uint64_t(1) << log2_entries) - 1)
+{
+  slots_ = new Slot[ size() ];
+  clear();
+  resetCounters();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+  delete [] slots_;
+}
+
+bool TranspositionTable::probe(uint64_t key, double& value)
+{
+  // Slots are picked by the low bits and stripes by the high ones, so
+  // neighbouring slots do not all count on one stripe.
+  Slot& slot = slots_[ key & mask_ ];
+  Counters& counters = counters_[ key >> 60 ];
+  counters.probes.fetch_add(1, RELAXED);
+
+  uint64_t data = slot.data.load(RELAXED);
+  uint64_t check = slot.check.load(RELAXED);
+  if((check ^ data) != key) {
+    return false;
+  }
+
+  counters.hits.fetch_add(1, RELAXED);
+  std::memcpy(&value, &data, sizeof(value));
+  return true;
+}
+
+void TranspositionTable::store(uint64_t key, double value)
+{
+  uint64_t data;
+  std::memcpy(&data, &value, sizeof(data));
+
+  Slot& slot = slots_[ key & mask_ ];
+  slot.data.store(data, RELAXED);
+  slot.check.store(key ^ data, RELAXED);
+  counters_[ key >> 60 ].stores.fetch_add(1, RELAXED);
+}
+
+void TranspositionTable::clear()
+{
+  for(size_t i = 0; i < size(); ++i) {
+    slots_[i].data.store(0, RELAXED);
+    slots_[i].check.store(EMPTY_CHECK, RELAXED);
+  }
+}
+
+uint64_t TranspositionTable::getProbes() const
+{
+  uint64_t n = 0;
+  for(int i = 0; i < STRIPES; ++i) {
+    n += counters_[i].probes.load(RELAXED);
+  }
+  return n;
+}
+
+uint64_t TranspositionTable::getHits() const
+{
+  uint64_t n = 0;
+  for(int i = 0; i < STRIPES; ++i) {
+    n += counters_[i].hits.load(RELAXED);
+  }
+  return n;
+}
+
+uint64_t TranspositionTable::getStores() const
+{
+  uint64_t n = 0;
+  for(int i = 0; i < STRIPES; ++i) {
+    n += counters_[i].stores.load(RELAXED);
+  }
+  return n;
+}
+
+double TranspositionTable::getHitRate() const
+{
+  uint64_t probes = getProbes();
+  return probes ? double(getHits()) / probes : 0.0;
+}
+
+void TranspositionTable::resetCounters()
+{
+  for(int i = 0; i < STRIPES; ++i) {
+    counters_[i].probes.store(0, RELAXED);
+    counters_[i].hits.store(0, RELAXED);
+    counters_[i].stores.store(0, RELAXED);
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * TranspositionTable - a fixed-size table of scores keyed by board
+ * hash, shared by searchers on any number of threads without locks.
+ * Each slot holds its data and the data XORed with the key, so a slot
+ * torn by two threads writing at once just fails to match and reads
+ * as a miss.
+ */
+
+#ifndef TRANSTABLE_H
+#define TRANSTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class TranspositionTable
+{
+public:
+  // A table of 2^log2_entries slots, empty.
+  explicit TranspositionTable(int log2_entries = 20);
+  ~TranspositionTable();
+
+  // Look key up.  On a hit, value is set and true returned.
+  bool probe(uint64_t key, double& value);
+
+  // Store value under key, replacing whatever had the slot.
+  void store(uint64_t key, double value);
+
+  // Empty every slot.  Not safe while other threads use the table.
+  void clear();
+
+  size_t size() const
+  {
+    return size_t(mask_) + 1;
+  }
+
+  // Counts since the table was made or the counters were last reset.
+  uint64_t getProbes() const;
+  uint64_t getHits() const;
+  uint64_t getStores() const;
+  double getHitRate() const;
+  void resetCounters();
+
+private:
+  TranspositionTable(const TranspositionTable&);
+  TranspositionTable& operator =(const TranspositionTable&);
+
+  struct Slot {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+
+  // The counters are split into stripes, one for each value of a key's
+  // top four bits and each on its own cache line, so threads counting
+  // at once rarely share one.
+  struct Counters {
+    std::atomic<uint64_t> probes;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> stores;
+    char pad[64 - 3 * sizeof(std::atomic<uint64_t>)];
+  };
+  static const int STRIPES = 16;
+
+  Slot* slots_;
+  uint64_t mask_;
+  Counters counters_[STRIPES];
+};
+
+#endif // TRANSTABLE_H
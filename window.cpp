@@ -1,8 +1,13 @@
 #include "window.h"
 #include "renderer.h"
+#include "bot.h"
+#include "workpool.h"
+#include <QDateTime>
+#include <QFile>
 
 #define INIT_TICK_DELAY 500
 #define MIN_TICK_DELAY  25
+#define SCRUB_TICKS     10
 
 Window::Window(QWidget *parent) :
     QMainWindow(parent)
@@ -27,6 +32,8 @@ Window::Window(QWidget *parent) :
     mDrawMenu->addAction(mWireAction);  // add wire
     mDrawMenu->addAction(mFaceAction);  // add wire
     mDrawMenu->addAction(mMultiAction);  // add wire
+    mDrawMenu->addSeparator();
+    mDrawMenu->addAction(mTimingsAction);  // add timings overlay
 
     // Setup the game menu
     mGameMenu = menuBar()->addMenu(tr("&Game"));
@@ -34,6 +41,9 @@ Window::Window(QWidget *parent) :
     mGameMenu->addAction(mSpeedUpAction);  // add speed up
     mGameMenu->addAction(mSlowDownAction);  // add speed down
     mGameMenu->addAction(mAutoIncAction);  // add auto increase speed
+    mGameMenu->addAction(mAutoplayAction);  // add autoplay
+    mGameMenu->addAction(mRewindAction);  // add rewind
+    mGameMenu->addAction(mForwardAction);  // add fast forward
 
     // Setup the application's widget collection
     QVBoxLayout * layout = new QVBoxLayout();
@@ -46,9 +56,18 @@ Window::Window(QWidget *parent) :
     mainWidget->setLayout(layout);
     setCentralWidget(mainWidget);
 
-    // Create game object
-    game = new Game(10, 20);
+    // Create game object, with a different piece sequence every run
+    game = new Game(10, 20, PieceSource(QDateTime::currentMSecsSinceEpoch()));
     renderer->setGame(game);
+    recorder = new InputRecorder(*game);
+    timeline = new Timeline(*game);
+    liveGame = 0;
+    scrubTick = 0;
+
+    // Create the autoplayer, idle until autoplay is switched on
+    autoplay = false;
+    botPool = new WorkPool();
+    bot = new Bot(heuristic, 16, 1, botPool);
 
     // Setup the game timer
     gameTimer = new QTimer(this);
@@ -63,12 +82,35 @@ Window::Window(QWidget *parent) :
     scoreLabel = new QLabel(this);
     //connect(quitButton, SIGNAL(clicked()), qApp, SLOT(quit()));
 
-    // Add game score label
+    // Add game score label, with the render timings beside it
     score = 0;
-    layout->addWidget(scoreLabel);
+    QHBoxLayout * labels = new QHBoxLayout();
+    layout->addLayout(labels);
+    timingsLabel = new QLabel(this);
+    timingsLabel->setFrameStyle(QFrame::Panel | QFrame::Sunken);
+    timingsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    timingsLabel->hide();
+    labels->addWidget(timingsLabel);
+    framesLabel = new QLabel(this);
+    framesLabel->setFrameStyle(QFrame::Panel | QFrame::Sunken);
+    framesLabel->setAlignment(Qt::AlignBottom | Qt::AlignLeft);
+    labels->addWidget(framesLabel);
+    labels->addWidget(scoreLabel);
     scoreLabel->setFrameStyle(QFrame::Panel | QFrame::Sunken);
     scoreLabel->setText("Score: 0");
     scoreLabel->setAlignment(Qt::AlignBottom | Qt::AlignRight);
+
+    // refreshes the timings while they are shown
+    timingsTimer = new QTimer(this);
+    connect(timingsTimer, SIGNAL(timeout()), this, SLOT(showTimings()));
+
+    // counts the frames drawn every second, whatever the game is doing,
+    // so an idle window can be seen to stop drawing
+    lastFrameCount = 0;
+    showFrames();
+    framesTimer = new QTimer(this);
+    connect(framesTimer, SIGNAL(timeout()), this, SLOT(showFrames()));
+    framesTimer->start(1000);
 }
 
 // helper function for creating actions
@@ -119,6 +161,13 @@ void Window::createActions()
     mFaceAction->setChecked(true);      // face mode on by default
     mMultiAction->setCheckable(true);
 
+    // Shows how long each part of a frame takes
+    mTimingsAction = new QAction(tr("&Timings"), this);
+    mTimingsAction->setShortcut(QKeySequence(Qt::Key_T));
+    mTimingsAction->setStatusTip(tr("Show render pass timings"));
+    mTimingsAction->setCheckable(true);
+    connect(mTimingsAction, SIGNAL(triggered()), this, SLOT(toggleTimings()));
+
     // Pauses the game
     mPauseAction = new QAction(tr("&Pause"), this);
     mPauseAction->setShortcut(QKeySequence(Qt::Key_P));
@@ -142,29 +191,100 @@ void Window::createActions()
     mAutoIncAction->setShortcut(QKeySequence(Qt::Key_A));
     mAutoIncAction->setStatusTip(tr("Automatically increase the speed"));
     connect(mAutoIncAction, SIGNAL(triggered()), this, SLOT(toggleAutoSpeed()));
+
+    // Let the computer play
+    mAutoplayAction = new QAction(tr("Auto&play"), this);
+    mAutoplayAction->setShortcut(QKeySequence(Qt::Key_B));
+    mAutoplayAction->setStatusTip(tr("Let the computer play"));
+    mAutoplayAction->setCheckable(true);
+    connect(mAutoplayAction, SIGNAL(triggered()), this, SLOT(toggleAutoplay()));
+
+    // Scrub back through the game
+    mRewindAction = new QAction(tr("&Rewind"), this);
+    mRewindAction->setShortcut(QKeySequence(Qt::Key_BracketLeft));
+    mRewindAction->setStatusTip(tr("Step back through the game"));
+    connect(mRewindAction, SIGNAL(triggered()), this, SLOT(rewind()));
+
+    // Scrub forward again, up to where the game is
+    mForwardAction = new QAction(tr("&Fast Forward"), this);
+    mForwardAction->setShortcut(QKeySequence(Qt::Key_BracketRight));
+    mForwardAction->setStatusTip(tr("Step forward through the game"));
+    connect(mForwardAction, SIGNAL(triggered()), this, SLOT(fastForward()));
 }
 
 // destructor
 Window::~Window()
 {
+    if (!timingsPath.isEmpty() && !renderer->writeTimings(timingsPath))
+        qWarning("could not write timings %s", qPrintable(timingsPath));
+    if (!recordPath.isEmpty())
+    {
+        // the session ends where the live game is, even if rewound
+        const std::vector<unsigned char> & bytes = recorder->finish(liveGame ? *liveGame : *game);
+        QFile file(recordPath);
+        if (!file.open(QIODevice::WriteOnly) ||
+            file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size()) != qint64(bytes.size()))
+            qWarning("could not write input log %s", qPrintable(recordPath));
+    }
+    delete recorder;
+    delete timeline;
+    delete liveGame;
+    delete bot;
+    delete botPool;
     delete renderer;
 }
 
 // Restarts the game
 void Window::newGame()
 {
+    stopScrubbing();
     score = 0;
     tickDelay = INIT_TICK_DELAY;
     gameTimer->setInterval(tickDelay);
     autoSpeed = false;
     elapsedAutoSpeedTime = 0;
     game->reset();
+    recordInput(INPUT_RESET);
+    renderer->update();
+}
+
+// Sets where the session's input log is saved
+void Window::recordTo(const QString & path)
+{
+    recordPath = path;
+}
+
+// Sets where the render timings are saved
+void Window::timingsTo(const QString & path)
+{
+    timingsPath = path;
 }
 
 // Game updating function
 void Window::gameUpdate()
 {
-    int points = game->tick();
+    // once the game is over, ticks change nothing and need no repaint
+    bool wasOver = game->isStopped();
+
+    // the autoplayer drops a piece straight into place every tick
+    int points = -1;
+    if (!autoplay)
+    {
+        points = game->tick();
+        recordInput(INPUT_TICK);
+    }
+    else
+    {
+        Placement best;
+        if (bot->choose(*game, best))
+        {
+            points = game->play(best);
+            recorder->recordPlay(best);
+            timeline->recordPlay(best, *game);
+        }
+    }
+    if (!wasOver)
+        renderer->update();
 
     if (points < 0)     // tick returns -1 if the game is over
         return;
@@ -184,10 +304,25 @@ void Window::gameUpdate()
         gameTimer->setInterval(tickDelay);
     }
     // update the score label
-    scoreLabel->setText("GameTickDelay: " + QString::number(tickDelay) + "\nScore: " + QString::number(score));    
+    showScore();
     elapsedAutoSpeedTime += tickDelay;
 }
 
+// Shows the tick delay and score
+void Window::showScore()
+{
+    scoreLabel->setText("GameTickDelay: " + QString::number(tickDelay) + "\nScore: " + QString::number(score));
+}
+
+// Shows the frames drawn so far and in the last second
+void Window::showFrames()
+{
+    long frames = renderer->getFrameCount();
+    framesLabel->setText("Frames: " + QString::number(frames) +
+                         "\nFrames/sec: " + QString::number(frames - lastFrameCount));
+    lastFrameCount = frames;
+}
+
 // turns auto speed increase on/off
 void Window::toggleAutoSpeed()
 {
@@ -195,6 +330,34 @@ void Window::toggleAutoSpeed()
     elapsedAutoSpeedTime = 0;
 }
 
+// shows/hides the render timings
+void Window::toggleTimings()
+{
+    if (mTimingsAction->isChecked())
+    {
+        showTimings();
+        timingsLabel->show();
+        timingsTimer->start(500);
+    }
+    else
+    {
+        timingsTimer->stop();
+        timingsLabel->hide();
+    }
+}
+
+// Shows the latest render timings
+void Window::showTimings()
+{
+    timingsLabel->setText(renderer->getTimingsSummary());
+}
+
+// turns autoplay on/off
+void Window::toggleAutoplay()
+{
+    autoplay = mAutoplayAction->isChecked();
+}
+
 // Increases gameplay speed
 void Window::incSpeed()
 {
@@ -212,7 +375,11 @@ void Window::decSpeed()
 // pause the game by stopping the timer
 void Window::pause()
 {
-    if (!gameTimer->isActive())
+    if (liveGame)
+    {
+        stopScrubbing();
+    }
+    else if (!gameTimer->isActive())
     {
         gameTimer->start(tickDelay);
     }
@@ -231,19 +398,39 @@ void Window::keyPressEvent(QKeyEvent *event)
             renderer->setIsScaling(true);
             break;
         case int(Qt::Key_Left):
-            game->moveLeft();
+            if (!liveGame)
+            {
+                game->moveLeft();
+                recordInput(INPUT_LEFT);
+            }
             break;
         case int(Qt::Key_Right):
-            game->moveRight();
+            if (!liveGame)
+            {
+                game->moveRight();
+                recordInput(INPUT_RIGHT);
+            }
             break;
         case int(Qt::Key_Up):
-            game->rotateCCW();
+            if (!liveGame)
+            {
+                game->rotateCCW();
+                recordInput(INPUT_ROTATE_CCW);
+            }
             break;
         case int(Qt::Key_Down):
-            game->rotateCW();
+            if (!liveGame)
+            {
+                game->rotateCW();
+                recordInput(INPUT_ROTATE_CW);
+            }
             break;
         case int(Qt::Key_Space):
-            game->drop();
+            if (!liveGame)
+            {
+                game->drop();
+                recordInput(INPUT_DROP);
+            }
             break;
         default:
             QMainWindow::keyPressEvent(event);
@@ -267,5 +454,59 @@ void Window::setDrawMode(QAction * action)
         renderer->setDrawMode(Renderer::FACES);
     else
         renderer->setDrawMode(Renderer::MULTI);
+    renderer->update();
+}
+
+// Passes an input just made on the game on to the session log and the
+// timeline
+void Window::recordInput(InputAction action)
+{
+    recorder->record(action);
+    timeline->record(action, *game);
+}
+
+// Steps back through the game's history, pausing it
+void Window::rewind()
+{
+    scrub(-SCRUB_TICKS);
+}
 
+// Steps forward through the game's history, up to where it is live
+void Window::fastForward()
+{
+    scrub(SCRUB_TICKS);
+}
+
+// Shows the game as it was delta ticks from the tick being shown.
+// The timer stays stopped until scrubbing stops.
+void Window::scrub(long delta)
+{
+    if (!liveGame)
+    {
+        liveGame = new Game(*game);
+        scrubTick = timeline->getLastTick();
+        gameTimer->stop();
+    }
+
+    scrubTick = std::max(timeline->getFirstTick(),
+                         std::min(timeline->getLastTick(), scrubTick + delta));
+    timeline->seek(scrubTick, *game);
+    scoreLabel->setText("Tick " + QString::number(scrubTick) + " of " +
+                        QString::number(timeline->getLastTick()) +
+                        "\nP to resume");
+    renderer->update();
+}
+
+// Puts the live game back and restarts the timer
+void Window::stopScrubbing()
+{
+    if (!liveGame)
+        return;
+
+    *game = *liveGame;
+    delete liveGame;
+    liveGame = 0;
+    gameTimer->start(tickDelay);
+    showScore();
+    renderer->update();
 }
@@ -10,6 +10,9 @@
 
 #include "math.h"
 #include "game.h"
+#include "heuristic.h"
+#include "inputlog.h"
+#include "timeline.h"
 #include <QMainWindow>
 #include <QApplication>
 #include <QMenuBar>
@@ -18,11 +21,15 @@
 #include <QMessageBox>
 #include <QPushButton>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFontDatabase>
 #include <QActionGroup>
 #include <QTimer>
 #include <QTime>
 
 class Renderer;
+class Bot;
+class WorkPool;
 
 class Window : public QMainWindow
 {
@@ -36,6 +43,14 @@ public:
     // destructor
     ~Window();
 
+    // write every input of this session to an input log at path when
+    // the window closes, for tetris-replay
+    void recordTo(const QString & path);
+
+    // write percentiles of the render pass timings to a CSV file at
+    // path when the window closes
+    void timingsTo(const QString & path);
+
 
 private slots:
     // game updte function
@@ -45,6 +60,11 @@ private slots:
     void newGame();
     // sets the draw mode of the renderer
     void setDrawMode(QAction * action);
+    // shows/hides the render timings, and refreshes them
+    void toggleTimings();
+    void showTimings();
+    // shows how many frames have been drawn
+    void showFrames();
     // pauses game
     void pause();
     // increases game speed
@@ -53,6 +73,11 @@ private slots:
     void decSpeed();
     // increases the game speed slowly over time
     void toggleAutoSpeed();
+    // hands the game over to the autoplayer, or takes it back
+    void toggleAutoplay();
+    // scrub back or forward through the game's history
+    void rewind();
+    void fastForward();
 
 protected:
     virtual void keyPressEvent(QKeyEvent * event);
@@ -73,12 +98,16 @@ private:
     QAction * mWireAction;
     QAction * mFaceAction;
     QAction * mMultiAction;
+    QAction * mTimingsAction;
 
     QMenu * mGameMenu;
     QAction * mPauseAction;
     QAction * mSpeedUpAction;
     QAction * mSlowDownAction;
     QAction * mAutoIncAction;
+    QAction * mAutoplayAction;
+    QAction * mRewindAction;
+    QAction * mForwardAction;
 
     // timer for calling game update function
     QTimer * gameTimer;
@@ -93,13 +122,51 @@ private:
     // Game reference
     Game * game;
 
+    // Autoplayer, which places a whole piece every game tick when on
+    bool autoplay;
+    WeightedHeuristic heuristic;
+    WorkPool * botPool;
+    Bot * bot;
+
+    // Every input to the game since it was created, and where to save
+    // them (nowhere if empty)
+    InputRecorder * recorder;
+    QString recordPath;
+
+    // Recent history of the game for scrubbing.  While scrubbing, game
+    // shows scrubTick and the live game waits in liveGame (null
+    // otherwise) with the timer stopped.
+    Timeline * timeline;
+    Game * liveGame;
+    long scrubTick;
+
     // Game score
     int score;
     // Score UI label
     QLabel * scoreLabel;
 
+    // Render timings label, where to save them (nowhere if empty), and
+    // the timer refreshing them while shown
+    QLabel * timingsLabel;
+    QString timingsPath;
+    QTimer * timingsTimer;
+
+    // Frame counter label, refreshed every second by its timer, and the
+    // count it last showed
+    QLabel * framesLabel;
+    QTimer * framesTimer;
+    long lastFrameCount;
+
     // helper function for creating actions
     void createActions();
+    // show the tick delay and score in the score label
+    void showScore();
+
+    // pass an input made on the game on to the recorder and timeline
+    void recordInput(InputAction action);
+    // show the game at scrubTick + delta, or go back to the live game
+    void scrub(long delta);
+    void stopScrubbing();
 };
 
 #endif // WINDOW_H
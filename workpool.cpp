@@ -0,0 +1,154 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * WorkPool - a fixed set of worker threads that split index ranges
+ * between them and steal from each other when they run dry.
+ */
+
+#include <algorithm>
+
+#include "workpool.h"
+
+namespace {
+
+uint64_t pack(uint32_t begin, uint32_t end)
+{
+  return uint64_t(end) << 32 | begin;
+}
+
+uint32_t beginOf(uint64_t span)
+{
+  return uint32_t(span);
+}
+
+uint32_t endOf(uint64_t span)
+{
+  return uint32_t(span >> 32);
+}
+
+} // namespace
+
+WorkPool::WorkPool(int threads)
+  : job_(nullptr)
+  , generation_(0)
+  , busy_(0)
+  , quit_(false)
+{
+  if(threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  ranges_ = std::vector<Range>(threads);
+  for(int i = 0; i < threads; ++i) {
+    ranges_[i].span = 0;
+  }
+  for(int i = 0; i < threads; ++i) {
+    workers_.push_back(std::thread(&WorkPool::workerLoop, this, i));
+  }
+}
+
+WorkPool::~WorkPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+
+  for(size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].join();
+  }
+}
+
+void WorkPool::run(long count, const std::function<void(long, int)>& fn)
+{
+  if(count <= 0) {
+    return;
+  }
+
+  // Hand every worker an equal slice up front; stealing evens out
+  // whatever imbalance is left.
+  int n = size();
+  for(int i = 0; i < n; ++i) {
+    ranges_[i].span = pack(uint32_t(count * i / n), uint32_t(count * (i+1) / n));
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  job_ = &fn;
+  busy_ = n;
+  ++generation_;
+  wake_.notify_all();
+
+  done_.wait(lock, [this]() { return busy_ == 0; });
+  job_ = nullptr;
+}
+
+// Claim the next index from the front of this worker's own range.
+bool WorkPool::takeOwn(int id, long& index)
+{
+  std::atomic<uint64_t>& span = ranges_[id].span;
+  uint64_t cur = span.load();
+
+  while(beginOf(cur) < endOf(cur)) {
+    if(span.compare_exchange_weak(cur, pack(beginOf(cur) + 1, endOf(cur)))) {
+      index = beginOf(cur);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Take the back half of the fullest-looking victim's range, starting
+// from the next worker along so thieves spread out.
+bool WorkPool::steal(int id)
+{
+  int n = size();
+
+  for(int k = 1; k < n; ++k) {
+    std::atomic<uint64_t>& victim = ranges_[(id + k) % n].span;
+    uint64_t cur = victim.load();
+
+    while(beginOf(cur) < endOf(cur)) {
+      uint32_t begin = beginOf(cur);
+      uint32_t end = endOf(cur);
+      uint32_t mid = begin + (end - begin) / 2;
+
+      if(victim.compare_exchange_weak(cur, pack(begin, mid))) {
+        ranges_[id].span = pack(mid, end);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void WorkPool::workerLoop(int id)
+{
+  unsigned long seen = 0;
+
+  while(true) {
+    const std::function<void(long, int)>* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+      if(quit_) {
+        return;
+      }
+      seen = generation_;
+      job = job_;
+    }
+
+    long index;
+    do {
+      while(takeOwn(id, index)) {
+        (*job)(index, id);
+      }
+    } while(steal(id));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
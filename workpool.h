@@ -0,0 +1,66 @@
+/*
+ * CPSC 453 - Introduction to Computer Graphics
+ * Assignment 1
+ *
+ * WorkPool - a fixed set of worker threads that split index ranges
+ * between them and steal from each other when they run dry.  Used to
+ * spread independent games or search nodes across all cores.
+ */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkPool
+{
+public:
+  // Start the given number of workers, or one per hardware thread
+  // if threads <= 0.
+  explicit WorkPool(int threads = 0);
+
+  ~WorkPool();
+
+  int size() const
+  {
+    return int(workers_.size());
+  }
+
+  // Call fn(i, worker) once for every i in [0, count) and return when
+  // all calls have finished.  worker is in [0, size()) and no two
+  // calls with the same worker run at once, so it can index per-worker
+  // scratch space.  Not reentrant: fn must not call run() itself.
+  void run(long count, const std::function<void(long, int)>& fn);
+
+private:
+  // The part of the current job one worker still owns, packed as
+  // begin in the low half and end in the high half so the owner and
+  // thieves can both update it with a single compare-and-swap.
+  struct Range {
+    std::atomic<uint64_t> span;
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  void workerLoop(int id);
+  bool takeOwn(int id, long& index);
+  bool steal(int id);
+
+  std::vector<std::thread> workers_;
+  std::vector<Range> ranges_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(long, int)>* job_;
+  unsigned long generation_;
+  int busy_;
+  bool quit_;
+};
+
+#endif // WORKPOOL_H